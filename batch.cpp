@@ -0,0 +1,253 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "runner.h"
+#include "thread_pool.h"
+
+namespace {
+    struct Job {
+        RunConfig config;
+        uint64_t expected_hash = 0;
+        bool has_expected = false;
+        int line = 0;
+    };
+
+    // "200,2A4-2AF": шестнадцатеричные адреса и диапазоны через запятую, все адреса - в addresses
+    bool parseAddresses(const char *text, std::vector<uint16_t> &addresses) {
+        char *end = nullptr;
+        for (;;) {
+            const unsigned low = static_cast<unsigned>(strtoul(text, &end, 16));
+            unsigned high = low;
+            if (end == text)
+                return false;
+            if (*end == '-')
+                high = static_cast<unsigned>(strtoul(end + 1, &end, 16));
+            if (low > high || high > 0xFFF)
+                return false;
+            for (unsigned address = low; address <= high; ++address)
+                addresses.push_back(static_cast<uint16_t>(address));
+            if (*end != ',')
+                return *end == '\0';
+            text = end + 1;
+        }
+    }
+
+    // Строка манифеста: <rom> [frames=N] [quirks=NAME] [seed=N] [rng=NAME] [speed=N] [movie=FILE] [expect=HEX]
+    //                   [break=ADDRS] [watch=ADDRS]
+    bool parseJob(const std::string &text, Job &job, std::string &error) {
+        std::istringstream in(text);
+        std::string token;
+        while (in >> token) {
+            const size_t eq = token.find('=');
+            if (eq == std::string::npos) {
+                if (!job.config.rom.empty()) {
+                    error = "two ROM paths";
+                    return false;
+                }
+                job.config.rom = token;
+                continue;
+            }
+
+            const std::string name = token.substr(0, eq);
+            const char *value = token.c_str() + eq + 1;
+            if (name == "frames") {
+                job.config.frames = strtoull(value, nullptr, 10);
+                job.config.frames_set = true;
+            } else if (name == "quirks") {
+                job.config.quirks_name = value;
+                job.config.quirks_set = true;
+            } else if (name == "seed") {
+                job.config.seed = static_cast<uint32_t>(strtoul(value, nullptr, 0));
+            } else if (name == "rng") {
+                if (!rngModeFromName(value, job.config.rng_mode)) {
+                    error = "unknown rng " + std::string(value);
+                    return false;
+                }
+            } else if (name == "speed") {
+                job.config.cycles_per_frame = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+            } else if (name == "movie") {
+                job.config.movie = value;
+            } else if (name == "break" || name == "watch") {
+                if (!parseAddresses(value, name == "break" ? job.config.breakpoints : job.config.watchpoints)) {
+                    error = "bad addresses in " + name;
+                    return false;
+                }
+            } else if (name == "expect") {
+                job.expected_hash = strtoull(value, nullptr, 16);
+                job.has_expected = true;
+            } else {
+                error = "unknown key " + name;
+                return false;
+            }
+        }
+
+        if (job.config.rom.empty()) {
+            error = "no ROM path";
+            return false;
+        }
+        if (!Quirks::fromName(job.config.quirks_name.c_str(), job.config.quirks)) {
+            error = "unknown quirks " + job.config.quirks_name;
+            return false;
+        }
+        return true;
+    }
+
+    // Ставит в строку манифеста expect=HEX вместо старого, комментарий оставляет на месте
+    std::string withExpected(const std::string &line, const uint64_t hash) {
+        const size_t comment = line.find('#');
+        std::string body = line.substr(0, comment);
+        const std::string tail = comment == std::string::npos ? "" : " " + line.substr(comment);
+        body = std::regex_replace(body, std::regex("\\s+expect=\\S*"), "");
+        body.erase(body.find_last_not_of(" \t\r\n") + 1);
+
+        char expect[32];
+        snprintf(expect, sizeof(expect), " expect=%016" PRIx64, hash);
+        return body + expect + tail;
+    }
+}
+
+// Пакетный прогон: задачи из манифеста раскидываются по всем ядрам, по экземпляру Chip8 на задачу.
+// Результаты пишутся по мере готовности, по строке на задачу.
+int main(int argc, char *argv[]) {
+    const char *manifest_path = nullptr;
+    unsigned threads = 0;
+    bool update = false;
+    const char *romdb_path = nullptr; // Только явный --romdb: эталонные хэши не зависят от окружения
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--update"))
+            update = true;
+        else if (!strcmp(argv[i], "--romdb") && i + 1 < argc)
+            romdb_path = argv[++i];
+        else
+            manifest_path = argv[i];
+    }
+
+    if (!manifest_path) {
+        fprintf(stderr, "Usage: chip8-batch <manifest|-> [--threads N] [--update] [--romdb FILE]\n"
+                "Manifest line: <rom> [frames=N] [quirks=NAME] [seed=N] [rng=xorshift|vip] [speed=N] [movie=FILE]\n"
+                "               [expect=HEX]\n"
+                "               [break=ADDRS] [watch=ADDRS]  (hex, e.g. 2A4,E00-E0F; a hit ends the job as stopped)\n"
+                "--update rewrites expect= in the manifest with the hashes of this run\n"
+                "--romdb sets quirks and speed of known ROMs unless the line gives them ($CHIP8_ROMDB is ignored)\n");
+        return 1;
+    }
+    if (update && !strcmp(manifest_path, "-")) {
+        fprintf(stderr, "--update needs a manifest file\n");
+        return 1;
+    }
+
+    RomDatabase romdb;
+    if (romdb_path && !romdb.open(romdb_path))
+        return 1;
+
+    FILE *manifest = strcmp(manifest_path, "-") ? fopen(manifest_path, "r") : stdin;
+    if (!manifest) {
+        fprintf(stderr, "Failed to open manifest %s\n", manifest_path);
+        return 1;
+    }
+
+    std::vector<Job> jobs;
+    std::vector<std::string> lines; // Как есть, для --update
+    char buffer[4096];
+    int line = 0;
+    while (fgets(buffer, sizeof(buffer), manifest)) {
+        ++line;
+        std::string text(buffer);
+        lines.push_back(text);
+        const size_t comment = text.find('#');
+        if (comment != std::string::npos)
+            text.erase(comment);
+        if (text.find_first_not_of(" \t\r\n") == std::string::npos)
+            continue;
+
+        Job job;
+        std::string error;
+        if (!parseJob(text, job, error)) {
+            fprintf(stderr, "%s:%d: %s\n", manifest_path, line, error.c_str());
+            return 1;
+        }
+        job.line = line;
+        if (romdb_path)
+            job.config.romdb = &romdb;
+        jobs.push_back(job);
+    }
+    if (manifest != stdin)
+        fclose(manifest);
+
+    std::mutex output;
+    size_t failures = 0;
+    std::vector<uint64_t> hashes(jobs.size());
+    std::vector<char> blessed(jobs.size()); // Прогон удался, хэш можно записать как эталон
+    const WorkStealingPool pool(threads);
+    pool.run(jobs.size(), [&](const size_t index) {
+        const Job &job = jobs[index];
+        const RunResult result = runHeadless(job.config);
+
+        const char *status = "ok";
+        if (!result.loaded)
+            status = "load-failed";
+        else if (!result.movie_match)
+            status = "movie-mismatch";
+        else if (job.has_expected && result.framebuffer_hash != job.expected_hash && !update)
+            status = "hash-mismatch";
+        else if (result.stop != StopReason::None)
+            status = "stopped"; // Сработал break= или watch=: это результат, а не провал
+        hashes[index] = result.framebuffer_hash;
+        blessed[index] = result.loaded && result.movie_match;
+
+        char stop_text[64] = "";
+        if (result.stop != StopReason::None)
+            snprintf(stop_text, sizeof(stop_text), " stop=%s stop_address=%03X pc=%03X", stopReasonName(result.stop),
+                     result.stop_address, result.pc);
+
+        char line_text[1024];
+        snprintf(line_text, sizeof(line_text),
+                 "line=%d rom=%s quirks=%s seed=%u frames=%" PRIu64 " cycles=%" PRIu64
+                 " framebuffer_hash=%016" PRIx64 " state_hash=%016" PRIx64 " fault=%s%s time_ms=%.3f status=%s\n",
+                 job.line, job.config.rom.c_str(),
+                 result.rom_record && !job.config.quirks_set ? "romdb" : job.config.quirks_name.c_str(),
+                 job.config.seed, result.frames, result.cycles, result.framebuffer_hash, result.state_hash,
+                 faultName(result.fault), stop_text, result.seconds * 1000, status);
+
+        // Одна строка - одна запись, чтобы вывод не перемешивался между потоками
+        std::lock_guard<std::mutex> lock(output);
+        fputs(line_text, stdout);
+        fflush(stdout);
+        if (!result.loaded) // Ядро при этом молчит: подробность - здесь, под той же блокировкой
+            fprintf(stderr, "line %d: failed to load %s%s%s\n", job.line, job.config.rom.c_str(),
+                    job.config.movie.empty() ? "" : " or ", job.config.movie.c_str());
+        if (strcmp(status, "ok") != 0 && strcmp(status, "stopped") != 0)
+            ++failures;
+    });
+
+    fprintf(stderr, "%zu jobs, %zu failed, %u threads\n", jobs.size(), failures, pool.threads());
+
+    if (update) {
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (!blessed[i])
+                continue;
+            std::string &text = lines[jobs[i].line - 1];
+            const bool newline = !text.empty() && text.back() == '\n';
+            text = withExpected(newline ? text.substr(0, text.size() - 1) : text, hashes[i]) + (newline ? "\n" : "");
+        }
+
+        FILE *out = fopen(manifest_path, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to write manifest %s\n", manifest_path);
+            return 1;
+        }
+        for (const std::string &text : lines)
+            fputs(text.c_str(), out);
+        fclose(out);
+    }
+    return failures ? 2 : 0;
+}
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "output.h"
+#include "savestate.h"
+
+namespace {
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0;
+        double ns_per_op = 0;
+        std::string fault; // Только для прогонов ROM
+    };
+
+    double min_seconds = 0.05;
+    int repeats = 5;
+    const char *filter = nullptr;
+    std::vector<Result> results;
+
+    double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // body(n) выполняет n операций. Число операций подбирается так, чтобы замер шёл не меньше min_seconds,
+    // из repeats замеров берётся лучший: он меньше всех зависит от соседей по машине.
+    void measure(const std::string &name, const std::function<void(uint64_t)> &body) {
+        if (filter && name.find(filter) == std::string::npos)
+            return;
+
+        uint64_t iterations = 1;
+        for (;;) {
+            const double start = now();
+            body(iterations);
+            const double elapsed = now() - start;
+            if (elapsed >= min_seconds || iterations >= (1ULL << 40))
+                break;
+            const double scale = elapsed > 0 ? min_seconds / elapsed * 1.2 : 16;
+            iterations = static_cast<uint64_t>(iterations * std::min(std::max(scale, 2.0), 16.0));
+        }
+
+        double best = 1e300;
+        for (int r = 0; r < repeats; ++r) {
+            const double start = now();
+            body(iterations);
+            best = std::min(best, now() - start);
+        }
+
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        result.ns_per_op = best * 1e9 / static_cast<double>(iterations);
+        results.push_back(result);
+    }
+
+    // ROM-петля: пролог, потом тело до 0x7F0 и прыжок на начало тела.
+    // По 0x800 - 00EE для 2NNN, по 0x900 - 16 байт 0xFF под спрайты и FX33/FX55.
+    std::vector<uint8_t> makeLoop(const std::vector<uint16_t> &prologue,
+                                  const std::function<uint16_t(uint16_t address, size_t i)> &body) {
+        std::vector<uint8_t> rom(0x710, 0);
+        uint16_t address = 0x200;
+        const auto put = [&](const uint16_t opcode) {
+            rom[address - 0x200] = opcode >> 8;
+            rom[address - 0x200 + 1] = opcode & 0xFF;
+            address += 2;
+        };
+
+        for (const uint16_t opcode : prologue)
+            put(opcode);
+        const uint16_t start = address;
+        for (size_t i = 0; address < 0x7F0; ++i)
+            put(body(address, i));
+        put(0x1000 | start);
+
+        address = 0x800;
+        put(0x00EE);
+        std::fill(rom.begin() + 0x700, rom.begin() + 0x710, 0xFF);
+        return rom;
+    }
+
+    std::vector<uint8_t> makeLoop(const std::vector<uint16_t> &prologue, const std::vector<uint16_t> &pattern) {
+        return makeLoop(prologue, [&](uint16_t, const size_t i) { return pattern[i % pattern.size()]; });
+    }
+
+    void benchmarkProgram(const std::string &name, const std::vector<uint8_t> &rom, const Quirks &quirks = Quirks()) {
+        Chip8 chip8;
+        chip8.initialize();
+        chip8.setQuirks(quirks);
+        chip8.loadROM(rom.data(), rom.size());
+        // Операция - одна инструкция
+        measure(name, [&](uint64_t count) {
+            while (count) {
+                const uint32_t step = static_cast<uint32_t>(std::min<uint64_t>(count, 1u << 30));
+                chip8.runCycles(step);
+                count -= step;
+            }
+        });
+        if (chip8.getFault() != Fault::None)
+            fprintf(stderr, "%s: %s at 0x%03X\n", name.c_str(), faultName(chip8.getFault()),
+                    chip8.getState().program_counter);
+    }
+
+    void benchmarkDispatch() {
+        // Пролог: I = 0x900, V1 = 1. Все ветвления подобраны так, чтобы не прыгать мимо петли.
+        const std::vector<uint16_t> prologue = {0xA900, 0x6101};
+        benchmarkProgram("dispatch/1NNN", makeLoop(prologue, [](const uint16_t address, size_t) {
+            return static_cast<uint16_t>(0x1000 | (address + 2));
+        }));
+        benchmarkProgram("dispatch/2NNN+00EE", makeLoop(prologue, std::vector<uint16_t>{0x2800}));
+        benchmarkProgram("dispatch/3XNN", makeLoop(prologue, std::vector<uint16_t>{0x3001}));
+        benchmarkProgram("dispatch/4XNN", makeLoop(prologue, std::vector<uint16_t>{0x4000}));
+        benchmarkProgram("dispatch/5XY0", makeLoop(prologue, std::vector<uint16_t>{0x5010}));
+        benchmarkProgram("dispatch/6XNN", makeLoop(prologue, std::vector<uint16_t>{0x6A12}));
+        benchmarkProgram("dispatch/7XNN", makeLoop(prologue, std::vector<uint16_t>{0x7A01}));
+        benchmarkProgram("dispatch/8XYN", makeLoop(prologue, std::vector<uint16_t>{
+                             0x8A10, 0x8A11, 0x8A12, 0x8A13, 0x8A14, 0x8A15, 0x8A16, 0x8A17, 0x8A1E}));
+        benchmarkProgram("dispatch/9XY0", makeLoop(prologue, std::vector<uint16_t>{0x9000}));
+        benchmarkProgram("dispatch/ANNN", makeLoop(prologue, std::vector<uint16_t>{0xA900}));
+        benchmarkProgram("dispatch/BNNN", makeLoop(prologue, [](const uint16_t address, size_t) {
+            return static_cast<uint16_t>(0xB000 | (address + 2)); // V0 = 0
+        }));
+        benchmarkProgram("dispatch/CXNN", makeLoop(prologue, std::vector<uint16_t>{0xCAFF}));
+        benchmarkProgram("dispatch/EX9E", makeLoop(prologue, std::vector<uint16_t>{0xE09E})); // Клавиша не нажата
+        benchmarkProgram("dispatch/FXNN", makeLoop(prologue, std::vector<uint16_t>{
+                             0xFA07, 0xFA15, 0xFA18, 0xF01E, 0xFA29, 0xA900, 0xFA33, 0xF355, 0xF365}));
+    }
+
+    void benchmarkDraw() {
+        benchmarkProgram("draw/00E0", makeLoop({}, std::vector<uint16_t>{0x00E0}));
+
+        struct Case {
+            const char *name;
+            uint8_t x, y, height;
+            bool clip;
+        };
+        const Case cases[] = {
+            {"draw/DXYN/h1", 8, 8, 1, false},
+            {"draw/DXYN/h5", 8, 8, 5, false},
+            {"draw/DXYN/h15", 8, 8, 15, false},
+            {"draw/DXYN/h15_wrap", 60, 28, 15, false},
+            {"draw/DXYN/h15_clip", 60, 28, 15, true},
+        };
+        for (const Case &c : cases) {
+            Quirks quirks;
+            quirks.clip_sprites = c.clip;
+            const std::vector<uint16_t> prologue = {0xA900, static_cast<uint16_t>(0x6000 | c.x),
+                                                    static_cast<uint16_t>(0x6100 | c.y)};
+            benchmarkProgram(c.name, makeLoop(prologue, std::vector<uint16_t>{static_cast<uint16_t>(0xD010 | c.height)}),
+                             quirks);
+        }
+    }
+
+    void benchmarkOutput() {
+        uint8_t gfx[64 * 32];
+        uint32_t seed = 1;
+        for (uint8_t &pixel : gfx) {
+            seed = seed * 1103515245 + 12345;
+            pixel = seed >> 16 & 1;
+        }
+        uint32_t pixels[64 * 32];
+        measure("render/framebuffer_to_pixels", [&](uint64_t count) {
+            for (; count; --count) {
+                framebufferToPixels(gfx, pixels);
+                // Не даём компилятору выкинуть преобразование
+                __asm__ __volatile__("" : : "r"(pixels) : "memory");
+            }
+        });
+
+        int16_t samples[44100 / 60];
+        uint32_t phase = 0;
+        measure("audio/square_wave_frame", [&](uint64_t count) {
+            for (; count; --count) {
+                squareWave(samples, 44100 / 60, 44100 / 440 / 2, phase);
+                __asm__ __volatile__("" : : "r"(samples) : "memory");
+            }
+        });
+    }
+
+    void benchmarkState() {
+        Chip8 chip8;
+        chip8.initialize();
+        const std::vector<uint8_t> rom = makeLoop({0xA900}, std::vector<uint16_t>{0x7A01, 0xD015, 0xFA33});
+        chip8.loadROM(rom.data(), rom.size());
+        chip8.runCycles(1000);
+
+        std::vector<uint8_t> buffer(savestate_size);
+        measure("savestate/save", [&](uint64_t count) {
+            for (; count; --count)
+                saveState(chip8, buffer.data(), buffer.size());
+        });
+        measure("savestate/load", [&](uint64_t count) {
+            for (; count; --count)
+                loadState(chip8, buffer.data(), buffer.size());
+        });
+
+        const Chip8State saved = chip8.getState();
+        measure("savestate/set_state", [&](uint64_t count) {
+            for (; count; --count)
+                chip8.setState(saved);
+        });
+
+        Chip8State target = saved;
+        measure("savestate/copy_dirty_pages", [&](uint64_t count) {
+            // Типичный кадр: пара страниц памяти и несколько строк экрана
+            for (; count; --count)
+                copyDirtyPages(saved, target, 0x3ULL << 36, 0xFU << 8);
+        });
+
+        Chip8 fresh;
+        fresh.initialize();
+        fresh.loadROM(rom.data(), rom.size());
+        const Chip8State snapshot = fresh.getState();
+        chip8.reset(snapshot, 0);
+        measure("reset/snapshot", [&](uint64_t count) {
+            for (uint32_t seed = 0; count; --count, ++seed)
+                chip8.reset(snapshot, seed);
+        });
+        measure("reset/initialize_load", [&](uint64_t count) {
+            for (uint32_t seed = 0; count; --count, ++seed) {
+                chip8.initialize(seed);
+                chip8.loadROM(rom.data(), rom.size());
+            }
+        });
+    }
+
+    // Целый ROM: операция - одна инструкция, кадры идут как в эмуляторе (с таймерами)
+    void benchmarkRom(const char *path) {
+        Chip8 chip8;
+        chip8.initialize();
+        if (!chip8.loadROM(path))
+            return;
+
+        const std::string name = std::string("rom/") + path;
+        const uint32_t cycles_per_frame = chip8.getCyclesPerFrame();
+        measure(name, [&](uint64_t count) {
+            for (uint64_t frames = (count + cycles_per_frame - 1) / cycles_per_frame; frames; --frames)
+                chip8.runFrame();
+        });
+        if (!results.empty() && results.back().name == name)
+            results.back().fault = faultName(chip8.getFault());
+    }
+
+    std::string escape(const std::string &text) {
+        std::string out;
+        for (const char c : text) {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            if (static_cast<unsigned char>(c) >= 0x20)
+                out += c;
+        }
+        return out;
+    }
+}
+
+// Микробенчмарки ядра и вывода. Результат - JSON в stdout, чтобы сравнивать сборки между релизами.
+int main(int argc, char *argv[]) {
+    std::vector<const char *> roms;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+            min_seconds = strtod(argv[++i], nullptr) / 1000;
+        else if (!strcmp(argv[i], "--repeats") && i + 1 < argc)
+            repeats = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (argv[i][0] != '-')
+            roms.push_back(argv[i]);
+        else {
+            fprintf(stderr, "Usage: chip8-bench [--min-time MS] [--repeats N] [--filter SUBSTRING] [rom...]\n");
+            return 1;
+        }
+    }
+
+    benchmarkDispatch();
+    benchmarkDraw();
+    benchmarkOutput();
+    benchmarkState();
+    for (const char *rom : roms)
+        benchmarkRom(rom);
+
+    printf("{\n  \"min_time_ms\": %.0f,\n  \"repeats\": %d,\n  \"benchmarks\": [\n", min_seconds * 1000, repeats);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result &result = results[i];
+        printf("    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_second\": %.0f",
+               escape(result.name).c_str(), static_cast<unsigned long long>(result.iterations), result.ns_per_op,
+               result.ns_per_op > 0 ? 1e9 / result.ns_per_op : 0.0);
+        if (!result.fault.empty())
+            printf(", \"fault\": \"%s\"", result.fault.c_str());
+        printf("}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+    return 0;
+}
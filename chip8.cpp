@@ -1,320 +1,336 @@
 #include "chip8.h"
 
+#include <cstring>
 #include <iostream>
 
-#include "lib/tinyfiledialogs/tinyfiledialogs.h"
-
-void Chip8::initialize() {
-    opcode = 0;
-    index = 0;
-    program_counter = 0x200;
-    stack_pointer = 0;
-    delay_timer = 0;
-    sound_timer = 0;
-    window = nullptr;
-    renderer = nullptr;
-    texture = nullptr;
-
-    memset(memory, 0, sizeof(memory));
-    memset(V, 0, sizeof(V));
-    memset(stack, 0, sizeof(stack));
-    memset(gfx, 0, sizeof(gfx));
-    memset(key, 0, sizeof(key));
-
-    const uint8_t chip8_fontset[80] =
-    {
-        0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-        0x20, 0x60, 0x20, 0x20, 0x70, // 1
-        0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-        0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-        0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-        0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-        0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-        0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-        0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-        0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-        0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-        0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-        0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-        0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-        0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-        0xF0, 0x80, 0xF0, 0x80, 0x80 // F
-    };
-    for (int i = 0; i < 80; i++) {
-        memory[i] = chip8_fontset[i];
-    }
+#include "mapped_file.h"
+#include "savestate.h"
+
+// Шрифт 0-F, по 5 байт на символ, лежит с адреса 0 (см. FX29)
+static const uint8_t chip8_fontset[80] =
+{
+    0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+    0x20, 0x60, 0x20, 0x20, 0x70, // 1
+    0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+    0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+    0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+    0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+    0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+    0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+    0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+    0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+    0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+    0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+    0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+    0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+    0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+    0xF0, 0x80, 0xF0, 0x80, 0x80 // F
+};
+
+void Chip8::initialize(const uint32_t seed) {
+    state.opcode = 0;
+    state.index = 0;
+    state.program_counter = 0x200;
+    state.stack_pointer = 0;
+    state.delay_timer = 0;
+    state.sound_timer = 0;
+    state.fault = 0;
+    state.cycle_count = 0;
+    reseed(seed);
+    input_queue.clear();
+    reset_source = nullptr;
+
+    memset(state.memory, 0, sizeof(state.memory));
+    memset(state.V, 0, sizeof(state.V));
+    memset(state.stack, 0, sizeof(state.stack));
+    memset(state.gfx, 0, sizeof(state.gfx));
+    memset(state.key, 0, sizeof(state.key));
+    dirty_memory = ~0ULL;
+    dirty_gfx = ~0U;
+
+    memcpy(state.memory, chip8_fontset, sizeof(chip8_fontset));
 }
 
-void Chip8::setupGraphics() {
-    SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
-    window = SDL_CreateWindow("CHIP-8", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 320, 0);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, 64, 32);
+void Chip8::reseed(const uint32_t seed) {
+    state.rng_seed = seed;
+    // xorshift застревает в нуле, поэтому сид перемешиваем и ноль исключаем
+    state.rng_state = seed * 0x9E3779B9u ^ 0x6D2B79F5u;
+    if (!state.rng_state)
+        state.rng_state = 0x6D2B79F5u;
 }
 
-void Chip8::renderGraphics() const {
-    uint32_t pixels[64 * 32];
-    for (int i = 0; i < 64 * 32; ++i)
-        pixels[i] = gfx[i] ? 0xFFFFFFFF : 0x00000000;
+void Chip8::reset(const Chip8State &snapshot, const uint32_t seed) {
+    // Всё, что могло отличаться от снимка: снятое clearDirtyPages() и ещё не снятое
+    uint64_t memory_pages = reset_memory | dirty_memory;
+    uint32_t gfx_pages = reset_gfx | dirty_gfx;
+    if (reset_source != &snapshot) {
+        memory_pages = ~0ULL;
+        gfx_pages = ~0U;
+    }
 
-    SDL_UpdateTexture(texture, nullptr, pixels, 64 * sizeof(uint32_t));
-    SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
-    SDL_RenderPresent(renderer);
+    copyDirtyPages(snapshot, state, memory_pages, gfx_pages);
+    reseed(seed);
+    input_queue.clear();
+
+    reset_source = &snapshot;
+    reset_memory = 0;
+    reset_gfx = 0;
+    // Для тех, кто копит грязные страницы (перемотка), скопированное тоже изменилось,
+    // но следующему reset() копировать его снова не нужно
+    restored_memory |= memory_pages;
+    restored_gfx |= gfx_pages;
+    dirty_memory = 0;
+    dirty_gfx = 0;
 }
 
-void Chip8::handleKeyEvent(const SDL_Event &event) {
-    const bool pressed = (event.type == SDL_KEYDOWN);
-    switch (event.key.keysym.sym) {
-        case SDLK_1: key[0x1] = pressed;
-            break;
-        case SDLK_2: key[0x2] = pressed;
-            break;
-        case SDLK_3: key[0x3] = pressed;
-            break;
-        case SDLK_4: key[0xC] = pressed;
-            break;
-
-        case SDLK_q: key[0x4] = pressed;
-            break;
-        case SDLK_w: key[0x5] = pressed;
-            break;
-        case SDLK_e: key[0x6] = pressed;
-            break;
-        case SDLK_r: key[0xD] = pressed;
-            break;
-
-        case SDLK_a: key[0x7] = pressed;
-            break;
-        case SDLK_s: key[0x8] = pressed;
-            break;
-        case SDLK_d: key[0x9] = pressed;
-            break;
-        case SDLK_f: key[0xE] = pressed;
-            break;
-
-        case SDLK_z: key[0xA] = pressed;
-            break;
-        case SDLK_x: key[0x0] = pressed;
-            break;
-        case SDLK_c: key[0xB] = pressed;
-            break;
-        case SDLK_v: key[0xF] = pressed;
-            break;
-        default:
-            break;
-    }
+bool Chip8::queueKeyEvent(const uint8_t k, const bool pressed, const uint64_t cycle) {
+    InputEvent event;
+    event.cycle = cycle;
+    event.key = k & 0xF;
+    event.pressed = pressed;
+    return input_queue.push(event);
 }
 
-void Chip8::loadROM(const char *filename) {
-    FILE *rom = fopen(filename, "rb");
-    if (!rom) {
+bool Chip8::loadROM(const char *filename) {
+    // Из отображения файла прямо в память машины: единственная копия
+    MappedFile rom;
+    if (!rom.open(filename)) {
         std::cout << "Failed to open file " << filename << std::endl;
-        exit(1);
+        return false;
     }
+    return loadROM(rom.data(), rom.size());
+}
+
+bool Chip8::loadROM(const uint8_t *data, size_t size) {
+    if (size > sizeof(state.memory) - 0x200)
+        size = sizeof(state.memory) - 0x200;
+    if (!size)
+        return false;
 
-    const size_t bytesRead = fread(memory + 0x200, 1, sizeof(this->memory) - 0x200, rom);
-    std::cout << "Loaded file " << filename << " (Bytes read: " << bytesRead << ")" << std::endl;
-    fclose(rom);
+    memcpy(state.memory + 0x200, data, size);
+    markMemoryDirty(0x200, static_cast<uint16_t>(size));
+    return true;
 }
 
 void Chip8::emulateCycle() {
-    opcode = memory[program_counter] << 8 | memory[program_counter + 1];
+    // Адреса везде заворачиваются в 4 Кб: ROM не может вывести машину за пределы памяти
+    state.opcode = state.memory[state.program_counter & 0xFFF] << 8 | state.memory[(state.program_counter + 1) & 0xFFF];
 
-    switch (opcode & 0xF000) {
+    switch (state.opcode & 0xF000) {
         case 0x0000: {
-            switch (opcode & 0x00FF) {
+            switch (state.opcode & 0x00FF) {
                 case 0x00E0: {
                     // Clears the screen.
-                    memset(gfx, 0, sizeof(gfx));
-                    program_counter += 2;
+                    memset(state.gfx, 0, sizeof(state.gfx));
+                    dirty_gfx = ~0U;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x00EE: {
                     // Returns from a subroutine.
-                    program_counter = stack[stack_pointer];
-                    stack_pointer--;
-                    program_counter += 2;
+                    if (state.stack_pointer == 0) {
+                        state.fault = static_cast<uint8_t>(Fault::StackUnderflow);
+                        return;
+                    }
+                    state.program_counter = state.stack[state.stack_pointer];
+                    state.stack_pointer--;
+                    state.program_counter += 2;
                     break;
                 }
 
                 default:
-                    std::cout << "Unknown opcode: " << std::hex << opcode << std::dec << std::endl;
-                    exit(1);
+                    state.fault = static_cast<uint8_t>(Fault::UnknownOpcode);
+                    return;
             }
             break;
         }
 
         case 0x1000: {
             // Jumps to address NNN.
-            program_counter = opcode & 0x0FFF;
+            state.program_counter = state.opcode & 0x0FFF;
             break;
         }
 
         case 0x2000: {
             // Calls subroutine at NNN.
-            stack_pointer++;
-            stack[stack_pointer] = program_counter;
-            program_counter = opcode & 0x0FFF;
+            if (state.stack_pointer >= 15) {
+                state.fault = static_cast<uint8_t>(Fault::StackOverflow);
+                return;
+            }
+            state.stack_pointer++;
+            state.stack[state.stack_pointer] = state.program_counter;
+            state.program_counter = state.opcode & 0x0FFF;
             break;
         }
 
         case 0x3000: {
             // Skips the next instruction if VX equals NN (usually the next instruction is a jump to skip a code block).
-            if (V[(opcode & 0x0F00) >> 8] == (opcode & 0x00FF)) {
-                program_counter += 4;
+            if (state.V[(state.opcode & 0x0F00) >> 8] == (state.opcode & 0x00FF)) {
+                state.program_counter += 4;
             } else {
-                program_counter += 2;
+                state.program_counter += 2;
             }
             break;
         }
 
         case 0x4000: {
             // Skips the next instruction if VX does not equal NN (usually the next instruction is a jump to skip a code block).
-            if (V[(opcode & 0x0F00) >> 8] != (opcode & 0x00FF)) {
-                program_counter += 4;
+            if (state.V[(state.opcode & 0x0F00) >> 8] != (state.opcode & 0x00FF)) {
+                state.program_counter += 4;
             } else {
-                program_counter += 2;
+                state.program_counter += 2;
             }
             break;
         }
 
         case 0x5000: {
             // Skips the next instruction if VX equals VY (usually the next instruction is a jump to skip a code block).
-            if (V[(opcode & 0x0F00) >> 8] == V[(opcode & 0x00F0) >> 4]) {
-                program_counter += 4;
+            if (state.V[(state.opcode & 0x0F00) >> 8] == state.V[(state.opcode & 0x00F0) >> 4]) {
+                state.program_counter += 4;
             } else {
-                program_counter += 2;
+                state.program_counter += 2;
             }
             break;
         }
 
         case 0x6000: {
             // Sets VX to NN.
-            V[(opcode & 0x0F00) >> 8] = opcode & 0x00FF;
-            program_counter += 2;
+            state.V[(state.opcode & 0x0F00) >> 8] = state.opcode & 0x00FF;
+            state.program_counter += 2;
             break;
         }
 
         case 0x7000: {
             // Adds NN to VX (carry flag is not changed).
-            V[(opcode & 0x0F00) >> 8] += opcode & 0x00FF;
-            program_counter += 2;
+            state.V[(state.opcode & 0x0F00) >> 8] += state.opcode & 0x00FF;
+            state.program_counter += 2;
             break;
         }
 
         case 0x8000: {
-            switch (opcode & 0x000F) {
+            switch (state.opcode & 0x000F) {
                 case 0x0000: {
                     // Sets VX to the value of VY.
-                    V[(opcode & 0x0F00) >> 8] = V[(opcode & 0x00F0) >> 4];
-                    program_counter += 2;
+                    state.V[(state.opcode & 0x0F00) >> 8] = state.V[(state.opcode & 0x00F0) >> 4];
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0001: {
                     // Sets VX to VX or VY. (bitwise OR operation).
-                    V[(opcode & 0x0F00) >> 8] |= V[(opcode & 0x00F0) >> 4];
-                    program_counter += 2;
+                    state.V[(state.opcode & 0x0F00) >> 8] |= state.V[(state.opcode & 0x00F0) >> 4];
+                    if (quirks.logic_resets_vf)
+                        state.V[0xF] = 0;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0002: {
                     // Sets VX to VX and VY. (bitwise AND operation).
-                    V[(opcode & 0x0F00) >> 8] &= V[(opcode & 0x00F0) >> 4];
-                    program_counter += 2;
+                    state.V[(state.opcode & 0x0F00) >> 8] &= state.V[(state.opcode & 0x00F0) >> 4];
+                    if (quirks.logic_resets_vf)
+                        state.V[0xF] = 0;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0003: {
                     // Sets VX to VX xor VY.
-                    V[(opcode & 0x0F00) >> 8] ^= V[(opcode & 0x00F0) >> 4];
-                    program_counter += 2;
+                    state.V[(state.opcode & 0x0F00) >> 8] ^= state.V[(state.opcode & 0x00F0) >> 4];
+                    if (quirks.logic_resets_vf)
+                        state.V[0xF] = 0;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0004: {
                     // Adds VY to VX. VF is set to 1 when there's an overflow, and to 0 when there is not.
-                    const uint16_t sum = V[(opcode & 0x0F00) >> 8] + V[(opcode & 0x00F0) >> 4];
-                    V[0xF] = (sum > 255) ? 1 : 0;
-                    V[(opcode & 0x0F00) >> 8] = sum & 0xFF;
-                    program_counter += 2;
+                    // VF пишется последним во всех 8XY4-8XYE: при X = F остаётся флаг, а не результат
+                    const uint16_t sum = state.V[(state.opcode & 0x0F00) >> 8] + state.V[(state.opcode & 0x00F0) >> 4];
+                    state.V[(state.opcode & 0x0F00) >> 8] = sum & 0xFF;
+                    state.V[0xF] = (sum > 255) ? 1 : 0;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0005: {
                     // VY is subtracted from VX. VF is set to 0 when there's an underflow, and 1 when there is not. (i.e. VF set to 1 if VX >= VY and 0 if not).
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
-                    const uint8_t y = (opcode & 0x00F0) >> 4;
-                    V[0xF] = (V[x] >= V[y]) ? 1 : 0;
-                    V[x] = (V[x] - V[y]) & 0xFF;
-                    program_counter += 2;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
+                    const uint8_t y = (state.opcode & 0x00F0) >> 4;
+                    const uint8_t flag = (state.V[x] >= state.V[y]) ? 1 : 0;
+                    state.V[x] = (state.V[x] - state.V[y]) & 0xFF;
+                    state.V[0xF] = flag;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0006: {
                     // Shifts VX to the right by 1, then stores the least significant bit of VX prior to the shift into VF
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
-                    V[0xF] = V[x] & 0x1;
-                    V[x] >>= 1;
-                    program_counter += 2;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
+                    const uint8_t source = quirks.shift_uses_vy ? state.V[(state.opcode & 0x00F0) >> 4] : state.V[x];
+                    state.V[x] = source >> 1;
+                    state.V[0xF] = source & 0x1;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0007: {
                     // Sets VX to VY minus VX. VF is set to 0 when there's an underflow, and 1 when there is not. (i.e. VF set to 1 if VY >= VX).
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
-                    const uint8_t y = (opcode & 0x00F0) >> 4;
-                    V[0xF] = (V[y] >= V[x]) ? 1 : 0;
-                    V[x] = (V[y] - V[x]) & 0xFF;
-                    program_counter += 2;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
+                    const uint8_t y = (state.opcode & 0x00F0) >> 4;
+                    const uint8_t flag = (state.V[y] >= state.V[x]) ? 1 : 0;
+                    state.V[x] = (state.V[y] - state.V[x]) & 0xFF;
+                    state.V[0xF] = flag;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x000E: {
                     // Shifts VX to the left by 1, then sets VF to 1 if the most significant bit of VX prior to that shift was set, or to 0 if it was unset.
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
-                    V[0xF] = V[x] & 0x80;
-                    V[x] <<= 1;
-                    program_counter += 2;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
+                    const uint8_t source = quirks.shift_uses_vy ? state.V[(state.opcode & 0x00F0) >> 4] : state.V[x];
+                    state.V[x] = (source << 1) & 0xFF;
+                    state.V[0xF] = source >> 7;
+                    state.program_counter += 2;
                     break;
                 }
 
                 default:
-                    std::cout << "Unknown opcode: " << std::hex << opcode << std::dec << std::endl;
-                    exit(1);
+                    state.fault = static_cast<uint8_t>(Fault::UnknownOpcode);
+                    return;
             }
             break;
         }
 
         case 0x9000: {
             // Skips the next instruction if VX does not equal VY. (Usually the next instruction is a jump to skip a code block).
-            if (V[(opcode & 0x0F00) >> 8] != V[(opcode & 0x00F0) >> 4]) {
-                program_counter += 4;
+            if (state.V[(state.opcode & 0x0F00) >> 8] != state.V[(state.opcode & 0x00F0) >> 4]) {
+                state.program_counter += 4;
             } else {
-                program_counter += 2;
+                state.program_counter += 2;
             }
             break;
         }
 
         case 0xA000: {
             // Sets I to the address NNN.
-            index = opcode & 0x0FFF;
-            program_counter += 2;
+            state.index = state.opcode & 0x0FFF;
+            state.program_counter += 2;
             break;
         }
 
         case 0xB000: {
-            // Jumps to the address NNN plus V0.
-            program_counter = (opcode & 0x0FFF) + V[0];
+            // Jumps to the address NNN plus V0 (SUPER-CHIP: XNN plus VX).
+            const uint8_t offset = quirks.jump_uses_vx ? state.V[(state.opcode & 0x0F00) >> 8] : state.V[0];
+            state.program_counter = (state.opcode & 0x0FFF) + offset;
             break;
         }
 
         case 0xC000: {
             // Sets VX to the result of a bitwise and operation on a random number (Typically: 0 to 255) and NN.
-            V[(opcode & 0x0F00) >> 8] = (rand() % 256) & (opcode & 0x00FF);
-            program_counter += 2;
+            state.V[(state.opcode & 0x0F00) >> 8] = nextRandom() & (state.opcode & 0x00FF);
+            state.program_counter += 2;
             break;
         }
 
@@ -322,77 +338,58 @@ void Chip8::emulateCycle() {
             // Draws a sprite at coordinate (VX, VY) that has a width of 8 pixels and a height of N pixels. Each row of 8 pixels is read as bit-coded starting from memory location I; I value does not change after the execution of this instruction. As described above, VF is set to 1 if any screen pixels are flipped from set to unset when the sprite is drawn, and to 0 if that does not happen.
             // Это пиздец... (Кусок ГПТ кода, который я не понимаю)
 
-            const uint8_t x = V[(opcode & 0x0F00) >> 8];
-            const uint8_t y = V[(opcode & 0x00F0) >> 4];
-            const uint8_t height = opcode & 0x000F;
-
-            V[0xF] = 0;
-
-            for (int row = 0; row < height; ++row) {
-                const uint8_t sprite_byte = memory[index + row];
-                for (int col = 0; col < 8; ++col) {
-                    if ((sprite_byte & (0x80 >> col)) != 0) {
-                        const int x_pos = (x + col) % 64;
-                        const int y_pos = (y + row) % 32;
-                        const int index_gfx = x_pos + (y_pos * 64);
+            state.V[0xF] = drawSprite(state.V[(state.opcode & 0x0F00) >> 8], state.V[(state.opcode & 0x00F0) >> 4],
+                                      state.opcode & 0x000F);
 
-                        if (gfx[index_gfx] == 1)
-                            V[0xF] = 1;
-
-                        gfx[index_gfx] ^= 1;
-                    }
-                }
-            }
-
-            program_counter += 2;
+            state.program_counter += 2;
             break;
         }
 
         case 0xE000: {
-            switch (opcode & 0x00FF) {
+            switch (state.opcode & 0x00FF) {
                 case 0x009E:
                     // Skips the next instruction if the key stored in VX(only consider the lowest nibble) is pressed (usually the next instruction is a jump to skip a code block).
-                    if (key[V[(opcode & 0x0F00) >> 8]]) {
-                        program_counter += 4;
+                    if (state.key[state.V[(state.opcode & 0x0F00) >> 8] & 0xF]) {
+                        state.program_counter += 4;
                     } else {
-                        program_counter += 2;
+                        state.program_counter += 2;
                     }
                     break;
 
                 case 0x00A1:
                     // Skips the next instruction if the key stored in VX(only consider the lowest nibble) is not pressed (usually the next instruction is a jump to skip a code block).[24]
-                    if (!key[V[(opcode & 0x0F00) >> 8]]) {
-                        program_counter += 4;
+                    if (!state.key[state.V[(state.opcode & 0x0F00) >> 8] & 0xF]) {
+                        state.program_counter += 4;
                     } else {
-                        program_counter += 2;
+                        state.program_counter += 2;
                     }
                     break;
 
                 default:
-                    std::cout << "Unknown opcode: " << std::hex << opcode << std::dec << std::endl;
-                    exit(1);
+                    state.fault = static_cast<uint8_t>(Fault::UnknownOpcode);
+                    return;
             }
             break;
         }
 
         case 0xF000: {
-            switch (opcode & 0x00FF) {
+            switch (state.opcode & 0x00FF) {
                 case 0x0007: {
                     // Sets VX to the value of the delay timer.
-                    V[(opcode & 0x0F00) >> 8] = delay_timer;
-                    program_counter += 2;
+                    state.V[(state.opcode & 0x0F00) >> 8] = state.delay_timer;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x000A: {
                     // Потом доделать я ебал пока гпт код
                     // A key press is awaited, and then stored in VX (blocking operation, all instruction halted until next key event, delay and sound timers should continue processing).
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
                     bool key_pressed = false;
 
                     for (uint8_t i = 0; i < 16; ++i) {
-                        if (key[i]) {
-                            V[x] = i;
+                        if (state.key[i]) {
+                            state.V[x] = i;
                             key_pressed = true;
                             break;
                         }
@@ -401,113 +398,242 @@ void Chip8::emulateCycle() {
                     if (!key_pressed)
                         return;
 
-                    program_counter += 2;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0015: {
                     // Sets the delay timer to VX.
-                    delay_timer = V[(opcode & 0x0F00) >> 8];
-                    program_counter += 2;
+                    state.delay_timer = state.V[(state.opcode & 0x0F00) >> 8];
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0018: {
                     // Sets the sound timer to VX.
-                    sound_timer = V[(opcode & 0x0F00) >> 8];
-                    program_counter += 2;
+                    state.sound_timer = state.V[(state.opcode & 0x0F00) >> 8];
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x001E: {
                     // Adds VX to I. VF is not affected.
-                    index += V[(opcode & 0x0F00) >> 8];
-                    program_counter += 2;
+                    state.index += state.V[(state.opcode & 0x0F00) >> 8];
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0029: {
                     // Sets I to the location of the sprite for the character in VX(only consider the lowest nibble). Characters 0-F (in hexadecimal) are represented by a 4x5 font.
-                    index = V[(opcode & 0x0F00) >> 8] * 5;
-                    program_counter += 2;
+                    state.index = state.V[(state.opcode & 0x0F00) >> 8] * 5;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0033: {
                     // Stores the binary-coded decimal representation of VX, with the hundreds digit in memory at location in I, the tens digit at location I+1, and the ones digit at location I+2.
                     // Опять гпт код...
-                    const uint8_t value = V[(opcode & 0x0F00) >> 8];
-                    memory[index] = value / 100;
-                    memory[index + 1] = (value / 10) % 10;
-                    memory[index + 2] = value % 10;
-                    program_counter += 2;
+                    const uint8_t value = state.V[(state.opcode & 0x0F00) >> 8];
+                    markMemoryDirty(state.index, 3);
+                    state.memory[state.index & 0xFFF] = value / 100;
+                    state.memory[(state.index + 1) & 0xFFF] = (value / 10) % 10;
+                    state.memory[(state.index + 2) & 0xFFF] = value % 10;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0055: {
                     // Stores from V0 to VX (including VX) in memory, starting at address I. The offset from I is increased by 1 for each value written, but I itself is left unmodified.
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
+                    markMemoryDirty(state.index, x + 1);
                     for (uint8_t i = 0; i <= x; ++i) {
-                        memory[index + i] = V[i];
+                        state.memory[(state.index + i) & 0xFFF] = state.V[i];
                     }
-                    program_counter += 2;
+                    if (quirks.load_store_increments_i)
+                        state.index += x + 1;
+                    state.program_counter += 2;
                     break;
                 }
 
                 case 0x0065: {
                     // Fills V0 to VX (including VX) with values from memory, starting at address I. The offset from I is increased by 1 for each value read, but I itself is left unmodified.
-                    const uint8_t x = (opcode & 0x0F00) >> 8;
+                    const uint8_t x = (state.opcode & 0x0F00) >> 8;
                     for (uint8_t i = 0; i <= x; ++i) {
-                        V[i] = memory[index + i];
+                        state.V[i] = state.memory[(state.index + i) & 0xFFF];
                     }
-                    program_counter += 2;
+                    if (quirks.load_store_increments_i)
+                        state.index += x + 1;
+                    state.program_counter += 2;
                     break;
                 }
 
                 default:
-                    std::cout << "Unknown opcode: " << std::hex << opcode << std::dec << std::endl;
-                    exit(1);
+                    state.fault = static_cast<uint8_t>(Fault::UnknownOpcode);
+                    return;
             }
             break;
 
         default:
-            std::cout << "Unknown opcode: " << std::hex << opcode << std::dec << std::endl;
-            exit(1);
+            state.fault = static_cast<uint8_t>(Fault::UnknownOpcode);
+            return;
         }
     }
+}
+
+void Chip8::runCycles(const uint32_t count) {
+    NullHooks hooks;
+    runCyclesWith(count, hooks);
+}
+
+void Chip8::tickTimers() {
+    if (state.delay_timer > 0)
+        --state.delay_timer;
+
+    // Звук - забота фронтенда: он пищит, пока isSoundActive()
+    if (state.sound_timer > 0)
+        --state.sound_timer;
+}
+
+uint8_t Chip8::drawSprite(uint8_t x, uint8_t y, const uint8_t height) {
+    // С clip_sprites начальная точка заворачивается, а всё, что вылезло за край, отбрасывается
+    if (quirks.clip_sprites) {
+        x %= 64;
+        y %= 32;
+    }
+
+    uint8_t collision = 0;
+    for (int row = 0; row < height; ++row) {
+        if (quirks.clip_sprites && y + row >= 32)
+            break;
+        dirty_gfx |= 1U << ((y + row) % 32);
+        const uint8_t sprite_byte = state.memory[(state.index + row) & 0xFFF];
+        for (int col = 0; col < 8; ++col) {
+            if (quirks.clip_sprites && x + col >= 64)
+                break;
+            if ((sprite_byte & (0x80 >> col)) != 0) {
+                const int x_pos = (x + col) % 64;
+                const int y_pos = (y + row) % 32;
+                const int index_gfx = x_pos + (y_pos * 64);
+
+                if (state.gfx[index_gfx] == 1)
+                    collision = 1;
 
-    if (delay_timer > 0) {
-        --delay_timer;
+                state.gfx[index_gfx] ^= 1;
+            }
+        }
     }
+    return collision;
+}
 
-    if (sound_timer > 0) {
-        if (sound_timer == 1) {
-            SDL_AudioSpec want{}, have{};
+void Chip8::markMemoryDirty(const uint16_t address, const uint16_t length) {
+    const unsigned first = (address & 0xFFF) / dirty_page_size;
+    const unsigned last = ((address + length - 1) & 0xFFF) / dirty_page_size;
+    // Запись может перевалить через конец памяти - тогда помечаем обе части
+    for (unsigned page = first; page != last; page = (page + 1) % 64)
+        dirty_memory |= 1ULL << page;
+    dirty_memory |= 1ULL << last;
+}
 
-            want.freq = 44100;
-            want.format = AUDIO_S16SYS;
-            want.channels = 1;
-            want.samples = 2048;
-            want.callback = nullptr;
+uint8_t Chip8::nextRandom() {
+    if (rng_mode == RngMode::Vip) {
+        // VIP увеличивал R9 на каждой выборке инструкции, брал байт своего кода по адресу 0x100 + R9.0
+        // и прибавлял его к R9.1. У нас на месте интерпретатора пусто, если ROM туда ничего не положил.
+        const uint8_t r9_low = state.cycle_count & 0xFF;
+        const uint8_t r9_high = ((state.rng_state >> 8) & 0xFF) + state.memory[0x100 + r9_low];
+        state.rng_state = (r9_high << 8) | r9_low;
+        return r9_high;
+    }
 
-            const SDL_AudioDeviceID dev = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0);
-            if (!dev) return;
+    // xorshift32: без глобальной блокировки rand() и воспроизводимо для каждого экземпляра
+    uint32_t x = state.rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state.rng_state = x;
+    return x >> 24;
+}
 
-            const int sample_count = (have.freq * 100) / 1000;
-            auto *buffer = new int16_t[sample_count];
+uint64_t Chip8::framebufferHash() const {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const uint8_t pixel: state.gfx) {
+        hash ^= pixel;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
 
-            for (int i = 0; i < sample_count; ++i) {
-                buffer[i] = (i / (have.freq / 440 / 2)) % 2 ? 8000 : -8000;
-            }
+const char *faultName(const Fault fault) {
+    switch (fault) {
+        case Fault::None: return "none";
+        case Fault::UnknownOpcode: return "unknown-opcode";
+        case Fault::StackOverflow: return "stack-overflow";
+        case Fault::StackUnderflow: return "stack-underflow";
+    }
+    return "?";
+}
+
+const char *rngModeName(const RngMode mode) {
+    switch (mode) {
+        case RngMode::Xorshift: return "xorshift";
+        case RngMode::Vip: return "vip";
+    }
+    return "?";
+}
 
-            SDL_PauseAudioDevice(dev, 0);
-            SDL_QueueAudio(dev, buffer, sample_count * sizeof(int16_t));
-            SDL_Delay(100);
-            SDL_CloseAudioDevice(dev);
-            delete[] buffer;
+bool rngModeFromName(const char *name, RngMode &mode) {
+    for (const RngMode candidate : {RngMode::Xorshift, RngMode::Vip}) {
+        if (!strcmp(name, rngModeName(candidate))) {
+            mode = candidate;
+            return true;
         }
-        --sound_timer;
     }
+    return false;
+}
+
+bool Quirks::fromName(const char *name, Quirks &quirks) {
+    quirks = Quirks();
+    if (!strcmp(name, "default"))
+        return true;
+
+    if (!strcmp(name, "vip") || !strcmp(name, "chip8")) {
+        quirks.shift_uses_vy = true;
+        quirks.load_store_increments_i = true;
+        quirks.logic_resets_vf = true;
+        quirks.clip_sprites = true;
+        return true;
+    }
+
+    if (!strcmp(name, "schip")) {
+        quirks.jump_uses_vx = true;
+        quirks.clip_sprites = true;
+        return true;
+    }
+
+    if (!strcmp(name, "xochip")) {
+        quirks.shift_uses_vy = true;
+        quirks.load_store_increments_i = true;
+        return true;
+    }
+
+    return false;
+}
+
+uint8_t packQuirks(const Quirks &quirks) {
+    return static_cast<uint8_t>(quirks.shift_uses_vy | quirks.load_store_increments_i << 1 | quirks.jump_uses_vx << 2
+                                | quirks.logic_resets_vf << 3 | quirks.clip_sprites << 4);
+}
+
+Quirks unpackQuirks(const uint8_t bits) {
+    Quirks quirks;
+    quirks.shift_uses_vy = bits & 1;
+    quirks.load_store_increments_i = bits & 2;
+    quirks.jump_uses_vx = bits & 4;
+    quirks.logic_resets_vf = bits & 8;
+    quirks.clip_sprites = bits & 16;
+    return quirks;
+}
 
-    SDL_Delay(1);
+void Chip8::runFrame() {
+    runCycles(cycles_per_frame);
+    tickTimers();
 }
@@ -1,32 +1,215 @@
 #ifndef CHIP8_H
 #define CHIP8_H
-#include <SDL2/SDL.h>
+#include <cstddef>
 #include <cstdint>
+#include <type_traits>
+#include <vector>
 
-class Chip8 {
+#include "input_queue.h"
+
+// Генератор для CXNN
+enum class RngMode : uint8_t {
+    Xorshift, // xorshift32, состояние своё у каждого экземпляра
+    Vip, // Как в интерпретаторе COSMAC VIP: байт со страницы 0x100 плюс счётчик R9
+};
+
+const char* rngModeName(RngMode mode); // "xorshift", "vip"
+bool rngModeFromName(const char* name, RngMode& mode);
+
+// Всё состояние машины, без указателей. Тривиально копируется:
+// снимок и восстановление - это один memcpy (см. savestate.h).
+struct Chip8State {
+    // Сначала регистры, потом большие массивы: так "всё, кроме страниц" - это один непрерывный префикс
     uint16_t opcode = 0;
-    uint8_t memory[4 * 1024] = {}; // Память 4Кб
     uint8_t V[16] = {}; // Регистры V0-VF
     uint16_t index = 0;
     uint16_t program_counter = 0x200;
     uint16_t stack[16] = {};
     uint16_t stack_pointer = 0;
-    uint8_t gfx[64 * 32] = {}; // Графический буфер
     uint8_t delay_timer = 0;
     uint8_t sound_timer = 0;
+    uint8_t fault = 0; // Fault; машина стоит, пока не None
     uint8_t key[16] = {};
+    uint8_t reserved[5] = {}; // Всегда нули вместо выравнивания: stateChecksum хэширует все байты
+    uint64_t cycle_count = 0; // Сколько циклов выполнено с initialize()
+    uint32_t rng_seed = 0;
+    uint32_t rng_state = 1; // Для Vip: младший байт - R9.0, следующий - R9.1
+    uint8_t gfx[64 * 32] = {}; // Графический буфер, страница = строка экрана
+    uint8_t memory[4 * 1024] = {}; // Память 4Кб
+};
 
-    SDL_Window* window = nullptr;
-    SDL_Renderer* renderer = nullptr;
-    SDL_Texture* texture = nullptr;
+static_assert(std::is_trivially_copyable<Chip8State>::value, "Chip8State must stay memcpy-able");
+// Снимки и хэши берут состояние побайтно, поэтому скрытого выравнивания в нём быть не должно
+static_assert(offsetof(Chip8State, cycle_count) == 80 && offsetof(Chip8State, gfx) == 96,
+              "Chip8State fields moved: check for padding");
+static_assert(sizeof(Chip8State) == offsetof(Chip8State, memory) + sizeof(Chip8State::memory),
+              "Chip8State must have no padding");
+
+// Грязные страницы: память и экран поделены на куски по 64 байта, по биту на каждый
+constexpr size_t dirty_page_size = 64;
+constexpr size_t registers_size = offsetof(Chip8State, gfx);
+static_assert(sizeof(Chip8State::memory) / dirty_page_size == 64, "memory pages must fit in uint64_t");
+static_assert(sizeof(Chip8State::gfx) / dirty_page_size == 32, "gfx pages must fit in uint32_t");
+
+// Почему машина остановилась
+enum class Fault : uint8_t {
+    None,
+    UnknownOpcode, // PC указывает на неизвестную инструкцию (opcode в состоянии)
+    StackOverflow, // 2NNN при 15 вложенных вызовах
+    StackUnderflow, // 00EE без вызова
+};
+
+const char* faultName(Fault fault);
+
+// Места, где реализации CHIP-8 расходятся. По умолчанию - поведение этого эмулятора как было.
+struct Quirks {
+    bool shift_uses_vy = false; // 8XY6/8XYE сдвигают VY в VX (COSMAC VIP)
+    bool load_store_increments_i = false; // FX55/FX65 сдвигают I на X+1 (COSMAC VIP)
+    bool jump_uses_vx = false; // BXNN прыгает на XNN + VX (SUPER-CHIP)
+    bool logic_resets_vf = false; // 8XY1/8XY2/8XY3 обнуляют VF (COSMAC VIP)
+    bool clip_sprites = false; // DXYN обрезает спрайт у края вместо заворота
+
+    // "default", "vip" (он же "chip8"), "schip", "xochip"; false - неизвестное имя
+    static bool fromName(const char* name, Quirks& quirks);
+};
+
+// Quirks в байт, по биту на поле: так их хранят база настроек (romdb.h) и ролики (movie.h)
+uint8_t packQuirks(const Quirks& quirks);
+Quirks unpackQuirks(uint8_t bits);
+
+// Хуки runCyclesWith: вокруг каждой выполненной инструкции. Этот - пустой, после инлайна от него
+// в горячем цикле не остаётся ни одной инструкции. Профайлер (profiler.h) подставляет свой.
+// false из хука останавливает прогон: до инструкции - не выполняя её, после - сразу за ней (отладчик).
+struct NullHooks {
+    bool beforeInstruction(const Chip8State&) { return true; }
+    bool afterInstruction(const Chip8State&) { return true; }
+};
+
+class Chip8 {
+    Chip8State state;
+    uint32_t cycles_per_frame = 10; // Инструкций за кадр (60 кадров в секунду)
+    RngMode rng_mode = RngMode::Xorshift;
+    Quirks quirks;
+    uint64_t dirty_memory = ~0ULL; // Страницы, записанные с последнего clearDirtyPages()
+    uint32_t dirty_gfx = ~0U;
+    // Снимок последнего reset() и страницы, изменённые после него и уже снятые clearDirtyPages()
+    const Chip8State* reset_source = nullptr;
+    uint64_t reset_memory = ~0ULL;
+    uint32_t reset_gfx = ~0U;
+    // Скопированные reset(): грязные для наблюдателей, но со снимком совпадают
+    uint64_t restored_memory = 0;
+    uint32_t restored_gfx = 0;
+
+    InputQueue input_queue;
+    std::vector<InputEvent>* input_recorder = nullptr; // Куда писать применённые события (для Movie)
+
+    friend class LockstepEngine;
+
+    void reseed(uint32_t seed);
+    uint8_t nextRandom();
+    uint8_t drawSprite(uint8_t x, uint8_t y, uint8_t height); // Возвращает новое значение VF
+    void markMemoryDirty(uint16_t address, uint16_t length);
+
+    // Применяем все события, чей цикл уже наступил, строго в порядке поступления
+    void applyInputEvents() {
+        const InputEvent* event;
+        while ((event = input_queue.peek()) && event->cycle <= state.cycle_count) {
+            state.key[event->key] = event->pressed;
+            if (input_recorder) {
+                // Пишем фактический цикл применения - при воспроизведении событие попадёт туда же
+                InputEvent applied = *event;
+                applied.cycle = state.cycle_count;
+                input_recorder->push_back(applied);
+            }
+            input_queue.pop();
+        }
+    }
 
 public:
-    void initialize();
-    void setupGraphics();
-    void renderGraphics() const;
-    void handleKeyEvent(const SDL_Event& event);
-    void loadROM(const char* filename);
+    void initialize(uint32_t seed = 0);
+    // Ставит событие клавиатуры в очередь; оно применится перед циклом cycle
+    bool queueKeyEvent(uint8_t key, bool pressed, uint64_t cycle);
+    bool loadROM(const char* filename);
+    bool loadROM(const uint8_t* data, size_t size); // Из памяти; лишнее сверх 0xE00 байт отбрасывается
+    // Сброс к снимку, снятому после initialize + loadROM: копируются регистры и только страницы,
+    // изменённые с прошлого reset() к тому же снимку. Снимок должен жить, пока от него сбрасываются.
+    void reset(const Chip8State& snapshot, uint32_t seed);
     void emulateCycle();
+    // Выполняет count циклов, применяя события ввода на своих циклах; останавливается на ошибке
+    void runCycles(uint32_t count);
+    void tickTimers(); // Вызывается с частотой 60 Гц
+    void runFrame(); // cycles_per_frame циклов + один тик таймеров
+
+    // То же с хуками вокруг каждой инструкции; runCycles - это runCyclesWith с NullHooks.
+    // Возвращает, сколько инструкций выполнено: меньше count, если машина упала или хук остановил.
+    template <typename Hooks>
+    uint32_t runCyclesWith(uint32_t count, Hooks& hooks) {
+        // Упавшая машина стоит: повторно ошибочную инструкцию не выполняем
+        uint32_t i = 0;
+        while (i < count && !state.fault) {
+            applyInputEvents();
+            if (!hooks.beforeInstruction(state))
+                break;
+            emulateCycle();
+            ++state.cycle_count;
+            ++i;
+            if (!hooks.afterInstruction(state))
+                break;
+        }
+        return i;
+    }
+
+    template <typename Hooks>
+    void runFrameWith(Hooks& hooks) {
+        runCyclesWith(cycles_per_frame, hooks);
+        tickTimers();
+    }
+
+    // Быстрый путь для снимков в памяти (перемотка, run-ahead): без заголовка и контрольной суммы.
+    // События, ещё стоящие в очереди ввода, в состояние не входят.
+    const Chip8State& getState() const { return state; }
+    void setState(const Chip8State& saved) {
+        state = saved;
+        dirty_memory = ~0ULL;
+        dirty_gfx = ~0U;
+    }
+
+    // Что менялось с последнего clearDirtyPages(): снимки и перемотка копируют/сравнивают только это
+    uint64_t getDirtyMemoryPages() const { return dirty_memory | restored_memory; }
+    uint32_t getDirtyGfxPages() const { return dirty_gfx | restored_gfx; }
+    void clearDirtyPages() {
+        reset_memory |= dirty_memory;
+        reset_gfx |= dirty_gfx;
+        dirty_memory = 0;
+        dirty_gfx = 0;
+        restored_memory = 0;
+        restored_gfx = 0;
+    }
+    // Для тех, кто откатывает состояние к заведомо известному (run-ahead)
+    void setDirtyPages(uint64_t memory_pages, uint32_t gfx_pages) {
+        dirty_memory = memory_pages;
+        dirty_gfx = gfx_pages;
+        restored_memory = 0;
+        restored_gfx = 0;
+    }
+
+    uint64_t getCycleCount() const { return state.cycle_count; }
+    uint32_t getCyclesPerFrame() const { return cycles_per_frame; }
+    void setCyclesPerFrame(uint32_t cycles) { cycles_per_frame = cycles ? cycles : 1; }
+    uint32_t getSeed() const { return state.rng_seed; }
+    RngMode getRngMode() const { return rng_mode; }
+    void setRngMode(RngMode mode) { rng_mode = mode; }
+    const Quirks& getQuirks() const { return quirks; }
+    void setQuirks(const Quirks& profile) { quirks = profile; }
+    Fault getFault() const { return static_cast<Fault>(state.fault); }
+    void setInputRecorder(std::vector<InputEvent>* recorder) { input_recorder = recorder; }
+    std::vector<InputEvent>* getInputRecorder() const { return input_recorder; }
+    // Позиция чтения очереди ввода: спекулятивный прогон возвращает её назад вместе с состоянием,
+    // чтобы события применились и в настоящем прогоне. Только пока в очередь никто не пишет.
+    uint32_t getInputPosition() const { return input_queue.position(); }
+    void rewindInput(uint32_t position) { input_queue.rewind(position); }
+    bool isSoundActive() const { return state.sound_timer > 0; }
+    uint64_t framebufferHash() const; // FNV-1a по gfx
 };
 
 #endif //CHIP8_H
@@ -0,0 +1,85 @@
+#include "chip8_env.h"
+
+#include "env.h"
+
+struct chip8_env {
+    VecEnv env;
+
+    chip8_env(const EnvConfig &config, const size_t count) : env(config, count) {}
+};
+
+chip8_env *chip8_env_create(const chip8_env_config *config, const size_t count) {
+    if (!config || !config->rom || !count)
+        return nullptr;
+
+    EnvConfig env_config;
+    env_config.rom = config->rom;
+    if (!Quirks::fromName(config->quirks ? config->quirks : "default", env_config.quirks))
+        return nullptr;
+    if (config->rng && !rngModeFromName(config->rng, env_config.rng_mode))
+        return nullptr;
+    env_config.cycles_per_frame = config->cycles_per_frame;
+    env_config.max_frames = config->max_frames;
+    for (size_t i = 0; i < config->reward_count; ++i) {
+        RewardSource source;
+        source.address = config->rewards[i].address;
+        source.length = config->rewards[i].length;
+        source.format = config->rewards[i].format == CHIP8_REWARD_DIGITS ? RewardSource::Format::Digits
+                                                                         : RewardSource::Format::Binary;
+        source.scale = config->rewards[i].scale;
+        env_config.rewards.push_back(source);
+    }
+    env_config.done_on_value = config->done_on_value != 0;
+    env_config.done_address = config->done_address;
+    env_config.done_value = config->done_value;
+
+    chip8_env *env = new chip8_env(env_config, count);
+    if (!env->env.isLoaded()) {
+        delete env;
+        return nullptr;
+    }
+    return env;
+}
+
+void chip8_env_destroy(chip8_env *env) {
+    delete env;
+}
+
+size_t chip8_env_size(const chip8_env *env) {
+    return env->env.size();
+}
+
+size_t chip8_env_observation_size(void) {
+    return observation_size;
+}
+
+void chip8_env_set_buffers(chip8_env *env, uint8_t *observations, float *rewards, uint8_t *dones) {
+    EnvBuffers buffers;
+    buffers.observations = observations;
+    buffers.rewards = rewards;
+    buffers.dones = dones;
+    env->env.setBuffers(buffers);
+}
+
+int chip8_env_map_shared(chip8_env *env, const char *name) {
+    return env->env.mapSharedMemory(name) ? 1 : 0;
+}
+
+size_t chip8_env_shared_layout(const size_t count, size_t *observations, size_t *rewards, size_t *dones) {
+    const EnvLayout layout(count);
+    if (observations)
+        *observations = layout.observations;
+    if (rewards)
+        *rewards = layout.rewards;
+    if (dones)
+        *dones = layout.dones;
+    return layout.size;
+}
+
+int chip8_env_reset(chip8_env *env, const uint32_t *seeds) {
+    return env->env.reset(seeds) ? 1 : 0;
+}
+
+void chip8_env_step(chip8_env *env, const uint16_t *actions, const uint32_t frameskip) {
+    env->env.step(actions, frameskip);
+}
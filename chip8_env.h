@@ -0,0 +1,68 @@
+#ifndef CHIP8_ENV_H
+#define CHIP8_ENV_H
+/* C ABI над VecEnv (env.h) для FFI: ctypes, cffi, Rust и т. п. */
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define CHIP8_ENV_API __declspec(dllexport)
+#else
+#define CHIP8_ENV_API __attribute__((visibility("default")))
+#endif
+
+typedef struct chip8_env chip8_env;
+
+enum {
+    CHIP8_REWARD_BINARY = 0, /* Беззнаковое число, старший байт первым */
+    CHIP8_REWARD_DIGITS = 1, /* По десятичной цифре в байте, как пишет FX33 */
+};
+
+typedef struct {
+    uint16_t address;
+    uint8_t length;
+    uint8_t format; /* CHIP8_REWARD_* */
+    float scale;
+} chip8_reward_source;
+
+typedef struct {
+    const char *rom;
+    const char *quirks; /* NULL - "default" */
+    const char *rng; /* Генератор CXNN: "xorshift" или "vip"; NULL - "xorshift" */
+    uint32_t cycles_per_frame; /* 0 - по умолчанию */
+    uint64_t max_frames; /* 0 - без ограничения */
+    const chip8_reward_source *rewards;
+    size_t reward_count;
+    int done_on_value; /* Эпизод кончается, когда memory[done_address] == done_value */
+    uint16_t done_address;
+    uint8_t done_value;
+} chip8_env_config;
+
+/* NULL - не открылся ROM, неизвестный профиль причуд или генератор */
+CHIP8_ENV_API chip8_env *chip8_env_create(const chip8_env_config *config, size_t count);
+CHIP8_ENV_API void chip8_env_destroy(chip8_env *env);
+
+CHIP8_ENV_API size_t chip8_env_size(const chip8_env *env);
+CHIP8_ENV_API size_t chip8_env_observation_size(void); /* Байт на среду: 64 * 32 */
+
+/* Буферы вызывающего: observations [count][32][64], rewards [count], dones [count]; любой может быть NULL */
+CHIP8_ENV_API void chip8_env_set_buffers(chip8_env *env, uint8_t *observations, float *rewards, uint8_t *dones);
+
+/* POSIX shared memory: наблюдения, награды и флаги подряд, каждый кусок выровнен на 64 байта.
+   Смещения - chip8_env_shared_layout. 0 - ошибка. */
+CHIP8_ENV_API int chip8_env_map_shared(chip8_env *env, const char *name);
+CHIP8_ENV_API size_t chip8_env_shared_layout(size_t count, size_t *observations, size_t *rewards, size_t *dones);
+
+/* seeds - по одному на среду или NULL. 0 - не открылся ROM. */
+CHIP8_ENV_API int chip8_env_reset(chip8_env *env, const uint32_t *seeds);
+/* actions - маска нажатых клавиш на среду (бит k - клавиша k) */
+CHIP8_ENV_API void chip8_env_step(chip8_env *env, const uint16_t *actions, uint32_t frameskip);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHIP8_ENV_H */
@@ -0,0 +1,168 @@
+#include "debugger.h"
+
+const char *stopReasonName(const StopReason reason) {
+    switch (reason) {
+        case StopReason::None: return "none";
+        case StopReason::Breakpoint: return "breakpoint";
+        case StopReason::ReadWatch: return "read-watch";
+        case StopReason::WriteWatch: return "write-watch";
+        case StopReason::Register: return "register";
+        case StopReason::Step: return "step";
+        case StopReason::Fault: return "fault";
+    }
+    return "unknown";
+}
+
+void Debugger::assign(uint64_t *bits, uint16_t address, const bool enabled) {
+    address &= 0xFFF;
+    if (enabled)
+        bits[address >> 6] |= 1ULL << (address & 63);
+    else
+        bits[address >> 6] &= ~(1ULL << (address & 63));
+}
+
+uint16_t Debugger::registerValue(const Chip8State &state, const uint8_t reg) {
+    return reg == watch_index_register ? state.index : state.V[reg & 0xF];
+}
+
+bool Debugger::stop(const StopReason reason, const uint16_t address) {
+    stop_reason = reason;
+    stop_address = address;
+    step = StepMode::None;
+    return false;
+}
+
+void Debugger::clearBreakpoints() {
+    for (uint64_t &bits : breakpoints)
+        bits = 0;
+}
+
+void Debugger::setWatchpoint(const uint16_t address, const uint16_t length, const bool reads, const bool writes) {
+    for (uint16_t i = 0; i < length && i < 4096; ++i) {
+        if (reads)
+            assign(read_watch, static_cast<uint16_t>(address + i), true);
+        if (writes)
+            assign(write_watch, static_cast<uint16_t>(address + i), true);
+    }
+    watching_reads |= reads && length;
+    watching_writes |= writes && length;
+}
+
+void Debugger::clearWatchpoints() {
+    for (unsigned i = 0; i < 64; ++i)
+        read_watch[i] = write_watch[i] = 0;
+    watching_reads = false;
+    watching_writes = false;
+}
+
+void Debugger::watchRegister(const RegisterWatch &watch) {
+    register_watches.push_back(watch);
+    registers_before.resize(register_watches.size());
+}
+
+void Debugger::stepOver(const Chip8State &state) {
+    const uint16_t pc = state.program_counter & 0xFFF;
+    if ((state.memory[pc] & 0xF0) != 0x20) {
+        stepInto();
+        return;
+    }
+    step = StepMode::Over;
+    step_pc = (pc + 2) & 0xFFF;
+    step_sp = state.stack_pointer;
+}
+
+void Debugger::stepOut(const Chip8State &state) {
+    step = StepMode::Out;
+    step_sp = state.stack_pointer;
+}
+
+bool Debugger::beforeInstruction(const Chip8State &state) {
+    const uint16_t pc = state.program_counter & 0xFFF;
+    if (skip_breakpoint)
+        skip_breakpoint = false;
+    else if (test(breakpoints, pc)) {
+        stopped_before = true;
+        stopped_pc = pc;
+        return stop(StopReason::Breakpoint, pc);
+    }
+    if (step == StepMode::Over && pc == step_pc && state.stack_pointer == step_sp) {
+        stopped_before = true;
+        stopped_pc = pc;
+        return stop(StopReason::Step, pc);
+    }
+
+    access_length = 0;
+    if (watching_reads || watching_writes) {
+        const uint16_t opcode = static_cast<uint16_t>(state.memory[pc] << 8 | state.memory[(pc + 1) & 0xFFF]);
+        const uint16_t registers = ((opcode >> 8) & 0xF) + 1;
+        access_address = state.index;
+        if ((opcode & 0xF000) == 0xD000) {
+            access_length = opcode & 0xF; // Строки спрайта
+            access_write = false;
+        } else if ((opcode & 0xF0FF) == 0xF033) {
+            access_length = 3;
+            access_write = true;
+        } else if ((opcode & 0xF0FF) == 0xF055) {
+            access_length = registers;
+            access_write = true;
+        } else if ((opcode & 0xF0FF) == 0xF065) {
+            access_length = registers;
+            access_write = false;
+        }
+    }
+
+    for (size_t i = 0; i < register_watches.size(); ++i)
+        registers_before[i] = registerValue(state, register_watches[i].reg);
+    return true;
+}
+
+bool Debugger::afterInstruction(const Chip8State &state) {
+    if (access_length) {
+        const uint64_t *bits = access_write ? write_watch : read_watch;
+        for (uint16_t i = 0; i < access_length; ++i) {
+            const uint16_t address = (access_address + i) & 0xFFF;
+            if (test(bits, address))
+                return stop(access_write ? StopReason::WriteWatch : StopReason::ReadWatch, address);
+        }
+    }
+
+    for (size_t i = 0; i < register_watches.size(); ++i) {
+        const RegisterWatch &watch = register_watches[i];
+        const uint16_t value = registerValue(state, watch.reg);
+        if (value == registers_before[i])
+            continue;
+        if (watch.any_change || value == watch.value)
+            return stop(StopReason::Register, watch.reg);
+    }
+
+    if (step == StepMode::Into || (step == StepMode::Out && state.stack_pointer < step_sp))
+        return stop(StopReason::Step, state.program_counter & 0xFFF);
+    return true;
+}
+
+uint64_t Debugger::run(Chip8 &chip8, const uint64_t frames) {
+    // Остановились перед инструкцией - продолжаем с неё же, а не встаём снова.
+    // Если PC с тех пор сменили (gdb пишет PC), точку на новом адресе проверяем как обычно.
+    skip_breakpoint = stopped_before && stop_reason != StopReason::None
+                      && (chip8.getState().program_counter & 0xFFF) == stopped_pc;
+    stopped_before = false;
+    stop_reason = StopReason::None;
+
+    uint64_t done = 0;
+    while (done < frames && chip8.getFault() == Fault::None) {
+        const uint32_t per_frame = chip8.getCyclesPerFrame();
+        frame_cycles += chip8.runCyclesWith(per_frame > frame_cycles ? per_frame - frame_cycles : 0, *this);
+        // Упавший кадр заканчиваем, как runFrame: тик таймеров, кадр засчитан
+        if (frame_cycles >= per_frame || chip8.getFault() != Fault::None) {
+            chip8.tickTimers();
+            frame_cycles = 0;
+            ++done;
+        }
+        if (stop_reason != StopReason::None)
+            break;
+    }
+
+    if (stop_reason == StopReason::None && chip8.getFault() != Fault::None)
+        stop(StopReason::Fault, chip8.getState().program_counter & 0xFFF);
+    return done;
+}
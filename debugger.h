@@ -0,0 +1,100 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+
+// Почему отладчик остановил прогон
+enum class StopReason : uint8_t {
+    None, // Прошли все заданные кадры
+    Breakpoint, // Перед инструкцией по адресу с точкой останова
+    ReadWatch, // После инструкции, прочитавшей отслеживаемую память (DXYN, FX65)
+    WriteWatch, // После инструкции, записавшей в отслеживаемую память (FX33, FX55)
+    Register, // После инструкции, выполнившей условие на регистр
+    Step, // Шаг закончен
+    Fault, // Машина упала
+};
+
+const char* stopReasonName(StopReason reason); // "breakpoint", "write-watch" и т. п.
+
+constexpr uint8_t watch_index_register = 16; // RegisterWatch::reg для I
+
+// Условие на регистр: любое изменение или переход в заданное значение
+struct RegisterWatch {
+    uint8_t reg = 0; // 0-15 - VX, watch_index_register - I
+    bool any_change = true;
+    uint16_t value = 0; // При any_change == false: остановиться, когда регистр стал равен value
+};
+
+// Отладчик - это хуки для Chip8::runCyclesWith, то есть отдельная инстанциация горячего цикла.
+// Обычный прогон (runCycles, NullHooks) о нём не знает и не платит ни за одну проверку.
+// Точки останова - битовая карта на 4096 адресов: проверка на инструкцию - один сдвиг.
+// Обращения к памяти смотрим по декодированной инструкции (DXYN, FX33, FX55, FX65), чтение opcode не считается.
+class Debugger {
+    enum class StepMode : uint8_t { None, Into, Over, Out };
+
+    uint64_t breakpoints[64] = {};
+    uint64_t read_watch[64] = {};
+    uint64_t write_watch[64] = {};
+    bool watching_reads = false;
+    bool watching_writes = false;
+    std::vector<RegisterWatch> register_watches;
+    std::vector<uint16_t> registers_before; // Значения отслеживаемых регистров до инструкции
+
+    StepMode step = StepMode::None;
+    uint16_t step_pc = 0; // Over: куда вернётся вызов
+    uint16_t step_sp = 0; // Over: глубина стека вызова; Out: выйти ниже неё
+
+    // Обращение текущей инструкции к памяти, разобранное до её выполнения
+    uint16_t access_address = 0;
+    uint16_t access_length = 0;
+    bool access_write = false;
+
+    bool skip_breakpoint = false; // Продолжение после остановки: точку на текущем PC не проверяем
+    // Последняя остановка была до инструкции по этому адресу (Breakpoint или шаг через вызов).
+    // Остановки после инструкции (watch, регистр, шаг) точку на следующем PC не глушат.
+    bool stopped_before = false;
+    uint16_t stopped_pc = 0;
+    StopReason stop_reason = StopReason::None;
+    uint16_t stop_address = 0;
+    uint32_t frame_cycles = 0; // Циклов незаконченного кадра: остановка бывает посреди кадра
+
+    static bool test(const uint64_t* bits, uint16_t address) {
+        address &= 0xFFF;
+        return bits[address >> 6] >> (address & 63) & 1;
+    }
+    static void assign(uint64_t* bits, uint16_t address, bool enabled);
+    static uint16_t registerValue(const Chip8State& state, uint8_t reg);
+    bool stop(StopReason reason, uint16_t address);
+
+public:
+    void setBreakpoint(uint16_t address, bool enabled = true) { assign(breakpoints, address, enabled); }
+    bool hasBreakpoint(uint16_t address) const { return test(breakpoints, address); }
+    void clearBreakpoints();
+    // length байт с address (с заворотом по 4 Кб); reads/writes - на что останавливаться
+    void setWatchpoint(uint16_t address, uint16_t length, bool reads, bool writes);
+    void clearWatchpoints();
+    void watchRegister(const RegisterWatch& watch);
+    void clearRegisterWatches() { register_watches.clear(); }
+
+    // Следующий run остановится: через одну инструкцию; после возврата из вызова под PC
+    // (не вызов - как stepInto); после выхода из текущей подпрограммы (в главной программе - не остановится)
+    void stepInto() { step = StepMode::Into; }
+    void stepOver(const Chip8State& state);
+    void stepOut(const Chip8State& state);
+
+    // Идёт кадрами, пока не пройдёт frames кадров, не сработает условие или машина не упадёт.
+    // Кадр, прерванный остановкой, следующий run доигрывает. Возвращает число законченных кадров.
+    uint64_t run(Chip8& chip8, uint64_t frames);
+
+    StopReason getStopReason() const { return stop_reason; }
+    // Breakpoint, Step, Fault - PC; ReadWatch/WriteWatch - адрес памяти; Register - номер регистра
+    uint16_t getStopAddress() const { return stop_address; }
+    uint32_t getFrameCycles() const { return frame_cycles; }
+
+    bool beforeInstruction(const Chip8State& state);
+    bool afterInstruction(const Chip8State& state);
+};
+
+#endif //DEBUGGER_H
@@ -0,0 +1,285 @@
+#include "disasm.h"
+
+#include <algorithm>
+
+static uint16_t fetchOpcode(const uint8_t *memory, const uint16_t address) {
+    return static_cast<uint16_t>(memory[address & 0xFFF] << 8 | memory[(address + 1) & 0xFFF]);
+}
+
+bool isValidOpcode(const uint16_t opcode) {
+    switch (opcode >> 12) {
+        case 0x0:
+            return opcode == 0x00E0 || opcode == 0x00EE;
+        case 0x8: {
+            const unsigned n = opcode & 0xF;
+            return n <= 7 || n == 0xE;
+        }
+        case 0xE:
+            return (opcode & 0xFF) == 0x9E || (opcode & 0xFF) == 0xA1;
+        case 0xF:
+            switch (opcode & 0xFF) {
+                case 0x07: case 0x0A: case 0x15: case 0x18: case 0x1E:
+                case 0x29: case 0x33: case 0x55: case 0x65:
+                    return true;
+                default:
+                    return false;
+            }
+        default:
+            return true; // 5XY0 и 9XY0 ядро выполняет при любом младшем полубайте
+    }
+}
+
+std::string disassembleOpcode(const uint16_t opcode) {
+    const unsigned x = (opcode >> 8) & 0xF;
+    const unsigned y = (opcode >> 4) & 0xF;
+    const unsigned n = opcode & 0xF;
+    const unsigned nn = opcode & 0xFF;
+    const unsigned nnn = opcode & 0xFFF;
+    char text[32];
+
+    if (!isValidOpcode(opcode)) {
+        snprintf(text, sizeof(text), "DW 0x%04X", opcode);
+        return text;
+    }
+    switch (opcode >> 12) {
+        case 0x0: return opcode == 0x00E0 ? "CLS" : "RET";
+        case 0x1: snprintf(text, sizeof(text), "JP 0x%03X", nnn); break;
+        case 0x2: snprintf(text, sizeof(text), "CALL 0x%03X", nnn); break;
+        case 0x3: snprintf(text, sizeof(text), "SE V%X, 0x%02X", x, nn); break;
+        case 0x4: snprintf(text, sizeof(text), "SNE V%X, 0x%02X", x, nn); break;
+        case 0x5: snprintf(text, sizeof(text), "SE V%X, V%X", x, y); break;
+        case 0x6: snprintf(text, sizeof(text), "LD V%X, 0x%02X", x, nn); break;
+        case 0x7: snprintf(text, sizeof(text), "ADD V%X, 0x%02X", x, nn); break;
+        case 0x8: {
+            static const char *const names[16] = {"LD", "OR", "AND", "XOR", "ADD", "SUB", "SHR", "SUBN",
+                                                  "", "", "", "", "", "", "SHL", ""};
+            snprintf(text, sizeof(text), "%s V%X, V%X", names[n], x, y);
+            break;
+        }
+        case 0x9: snprintf(text, sizeof(text), "SNE V%X, V%X", x, y); break;
+        case 0xA: snprintf(text, sizeof(text), "LD I, 0x%03X", nnn); break;
+        case 0xB: snprintf(text, sizeof(text), "JP V0, 0x%03X", nnn); break;
+        case 0xC: snprintf(text, sizeof(text), "RND V%X, 0x%02X", x, nn); break;
+        case 0xD: snprintf(text, sizeof(text), "DRW V%X, V%X, %u", x, y, n); break;
+        case 0xE: snprintf(text, sizeof(text), "%s V%X", nn == 0x9E ? "SKP" : "SKNP", x); break;
+        default:
+            switch (nn) {
+                case 0x07: snprintf(text, sizeof(text), "LD V%X, DT", x); break;
+                case 0x0A: snprintf(text, sizeof(text), "LD V%X, K", x); break;
+                case 0x15: snprintf(text, sizeof(text), "LD DT, V%X", x); break;
+                case 0x18: snprintf(text, sizeof(text), "LD ST, V%X", x); break;
+                case 0x1E: snprintf(text, sizeof(text), "ADD I, V%X", x); break;
+                case 0x29: snprintf(text, sizeof(text), "LD F, V%X", x); break;
+                case 0x33: snprintf(text, sizeof(text), "LD B, V%X", x); break;
+                case 0x55: snprintf(text, sizeof(text), "LD [I], V%X", x); break;
+                default: snprintf(text, sizeof(text), "LD V%X, [I]", x); break;
+            }
+    }
+    return text;
+}
+
+static bool isSkip(const uint16_t opcode) {
+    const unsigned family = opcode >> 12;
+    return family == 0x3 || family == 0x4 || family == 0x5 || family == 0x9 || family == 0xE;
+}
+
+// Инструкция, после которой блок кончается
+static bool endsBlock(const uint16_t opcode) {
+    const unsigned family = opcode >> 12;
+    return !isValidOpcode(opcode) || opcode == 0x00EE || family == 0x1 || family == 0x2 || family == 0xB
+           || isSkip(opcode);
+}
+
+const BasicBlock *ProgramAnalysis::blockAt(const uint16_t start) const {
+    const auto found = std::lower_bound(blocks.begin(), blocks.end(), start,
+                                        [](const BasicBlock &block, const uint16_t address) {
+                                            return block.start < address;
+                                        });
+    return found != blocks.end() && found->start == start ? &*found : nullptr;
+}
+
+bool ProgramAnalysis::isSubroutine(const uint16_t address) const {
+    return std::binary_search(subroutines.begin(), subroutines.end(), address);
+}
+
+void analyzeProgram(const uint8_t *memory, uint16_t entry, ProgramAnalysis &analysis) {
+    entry &= 0xFFF;
+    analysis = ProgramAnalysis();
+    analysis.entry = entry;
+    uint8_t *bytes = analysis.bytes;
+
+    // Начала блоков: вход, цели переходов и вызовов, обе ветки пропусков, точки возврата
+    std::vector<uint8_t> leader(4096);
+    std::vector<uint16_t> work;
+    const auto follow = [&](const uint16_t target) {
+        leader[target & 0xFFF] = 1;
+        work.push_back(target & 0xFFF);
+    };
+    const auto markData = [&](const int index, const unsigned length) {
+        for (unsigned i = 0; index >= 0 && i < length; ++i)
+            bytes[(index + i) & 0xFFF] |= byte_data;
+    };
+
+    follow(entry);
+    while (!work.empty()) {
+        uint16_t pc = work.back();
+        work.pop_back();
+        int index = -1; // Известное значение I на этом прямом проходе
+
+        while (!(bytes[pc] & byte_code)) {
+            if (bytes[pc] & byte_operand || bytes[(pc + 1) & 0xFFF] & byte_code)
+                analysis.overlapping = true;
+            bytes[pc] |= byte_code;
+            bytes[(pc + 1) & 0xFFF] |= byte_operand;
+
+            const uint16_t opcode = fetchOpcode(memory, pc);
+            const uint16_t next = (pc + 2) & 0xFFF;
+            const unsigned x = (opcode >> 8) & 0xF;
+            if (leader[pc])
+                index = -1; // Сюда приходят и другими путями
+            switch (opcode >> 12) {
+                case 0xA: index = opcode & 0xFFF; break;
+                case 0xD: markData(index, opcode & 0xF); break;
+                case 0xF:
+                    if ((opcode & 0xFF) == 0x33)
+                        markData(index, 3);
+                    else if ((opcode & 0xFF) == 0x55 || (opcode & 0xFF) == 0x65) {
+                        markData(index, x + 1);
+                        index = -1; // С load_store_increments_i I сдвигается
+                    } else if ((opcode & 0xFF) == 0x1E || (opcode & 0xFF) == 0x29)
+                        index = -1;
+                    break;
+                default: break;
+            }
+
+            if (!endsBlock(opcode)) {
+                pc = next;
+                continue;
+            }
+            if ((opcode >> 12) == 0x1)
+                follow(opcode & 0xFFF);
+            else if ((opcode >> 12) == 0x2) {
+                follow(opcode & 0xFFF);
+                analysis.subroutines.push_back(opcode & 0xFFF);
+                follow(next);
+            } else if (isValidOpcode(opcode) && isSkip(opcode)) {
+                follow(next);
+                follow(pc + 4);
+            } else if ((opcode >> 12) == 0xB)
+                analysis.computed_jumps.push_back(pc);
+            break; // 00EE, BNNN, неизвестная инструкция - дальше не идём
+        }
+    }
+
+    std::sort(analysis.subroutines.begin(), analysis.subroutines.end());
+    analysis.subroutines.erase(std::unique(analysis.subroutines.begin(), analysis.subroutines.end()),
+                               analysis.subroutines.end());
+    std::sort(analysis.computed_jumps.begin(), analysis.computed_jumps.end());
+
+    // Блоки: от каждого начала до инструкции-перехода или до следующего начала
+    for (unsigned start = 0; start < 4096; ++start) {
+        if (!leader[start] || !(bytes[start] & byte_code))
+            continue;
+        BasicBlock block;
+        block.start = static_cast<uint16_t>(start);
+        uint16_t pc = block.start;
+        for (unsigned steps = 0; steps < 2048; ++steps) {
+            const uint16_t opcode = fetchOpcode(memory, pc);
+            const uint16_t next = (pc + 2) & 0xFFF;
+            if (endsBlock(opcode)) {
+                block.end = next;
+                const unsigned family = opcode >> 12;
+                if (!isValidOpcode(opcode))
+                    block.invalid = true;
+                else if (opcode == 0x00EE)
+                    block.returns = true;
+                else if (family == 0x1)
+                    block.successors.push_back({static_cast<uint16_t>(opcode & 0xFFF), EdgeKind::Jump});
+                else if (family == 0x2) {
+                    block.successors.push_back({static_cast<uint16_t>(opcode & 0xFFF), EdgeKind::Call});
+                    block.successors.push_back({next, EdgeKind::Next});
+                } else if (family == 0xB)
+                    block.computed = true;
+                else {
+                    block.successors.push_back({next, EdgeKind::Next});
+                    block.successors.push_back({static_cast<uint16_t>((pc + 4) & 0xFFF), EdgeKind::Skip});
+                }
+                break;
+            }
+            if (leader[next] || !(bytes[next] & byte_code)) {
+                block.end = next;
+                block.successors.push_back({next, EdgeKind::Next});
+                break;
+            }
+            pc = next;
+        }
+        analysis.blocks.push_back(block);
+    }
+}
+
+static constexpr int comment_column = 60;
+
+static void labelName(const ProgramAnalysis &analysis, const uint16_t address, char *text, const size_t size) {
+    snprintf(text, size, "%s_%03X", analysis.isSubroutine(address) ? "sub" : "L", address);
+}
+
+void writeListing(FILE *out, const uint8_t *memory, const ProgramAnalysis &analysis, const uint16_t start,
+                  const uint16_t end) {
+    fprintf(out, "; entry 0x%03X, %zu blocks, %zu subroutines, %zu computed jumps%s\n", analysis.entry,
+            analysis.blocks.size(), analysis.subroutines.size(), analysis.computed_jumps.size(),
+            analysis.overlapping ? ", overlapping instructions" : "");
+
+    unsigned address = start;
+    while (address < end) {
+        const uint8_t flags = analysis.bytes[address];
+        if (flags & byte_code) {
+            const BasicBlock *block = analysis.blockAt(static_cast<uint16_t>(address));
+            if (block) {
+                char label[16];
+                labelName(analysis, block->start, label, sizeof(label));
+                fprintf(out, "\n%s:\n", label);
+            }
+            const uint16_t opcode = fetchOpcode(memory, static_cast<uint16_t>(address));
+            const char *comment = (opcode >> 12) == 0xB ? "computed jump" : flags & byte_data ? "also read as data" : "";
+            const int width = fprintf(out, "    %03X  %04X  %s", address, opcode, disassembleOpcode(opcode).c_str());
+            if (*comment)
+                fprintf(out, "%*s; %s", width < comment_column ? comment_column - width : 1, "", comment);
+            fprintf(out, "\n");
+            address += 2;
+            continue;
+        }
+
+        // Не код: до 8 байт одного вида в строку
+        const bool data = (flags & byte_data) != 0;
+        unsigned count = 0;
+        int width = fprintf(out, "    %03X  DB", address);
+        while (address < end && count < 8 && !(analysis.bytes[address] & byte_code)
+               && ((analysis.bytes[address] & byte_data) != 0) == data) {
+            width += fprintf(out, "%s0x%02X", count ? ", " : " ", memory[address]);
+            ++address;
+            ++count;
+        }
+        fprintf(out, "%*s; %s\n", width < comment_column ? comment_column - width : 1, "", data ? "data" : "unreached");
+    }
+}
+
+void writeDot(FILE *out, const uint8_t *memory, const ProgramAnalysis &analysis) {
+    fprintf(out, "digraph chip8 {\n");
+    fprintf(out, "    node [shape=box, fontname=\"monospace\"];\n");
+    for (const BasicBlock &block : analysis.blocks) {
+        char label[16];
+        labelName(analysis, block.start, label, sizeof(label));
+        fprintf(out, "    b%03X [label=\"%s:\\l", block.start, label);
+        for (uint16_t pc = block.start; pc != block.end; pc = (pc + 2) & 0xFFF)
+            fprintf(out, "%03X  %s\\l", pc, disassembleOpcode(fetchOpcode(memory, pc)).c_str());
+        fprintf(out, "\"%s];\n", block.invalid || block.computed ? ", color=red" : "");
+    }
+    for (const BasicBlock &block : analysis.blocks) {
+        for (const Edge &edge : block.successors) {
+            static const char *const styles[] = {"", " [label=\"jump\"]", " [style=dashed, label=\"call\"]",
+                                                 " [label=\"skip\"]"};
+            fprintf(out, "    b%03X -> b%03X%s;\n", block.start, edge.target, styles[static_cast<unsigned>(edge.kind)]);
+        }
+    }
+    fprintf(out, "}\n");
+}
@@ -0,0 +1,61 @@
+#ifndef DISASM_H
+#define DISASM_H
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Мнемоника в нотации Cowgod: "LD V1, 0x05", "DRW V0, V1, 5". То, на чём ядро падает, - "DW 0x1234".
+std::string disassembleOpcode(uint16_t opcode);
+bool isValidOpcode(uint16_t opcode); // Ядро её выполняет, а не падает с UnknownOpcode
+
+// Разметка байтов памяти, флаги можно совмещать (самомодифицирующийся код)
+constexpr uint8_t byte_code = 0x01; // Начало достижимой инструкции
+constexpr uint8_t byte_operand = 0x02; // Второй байт инструкции
+constexpr uint8_t byte_data = 0x04; // Читается через I: спрайт DXYN, FX55/FX65, FX33
+
+enum class EdgeKind : uint8_t {
+    Next, // Следующая инструкция: проход насквозь, непропущенный skip, возврат из вызова
+    Jump, // 1NNN
+    Call, // 2NNN
+    Skip, // Сработавший 3XNN/4XNN/5XY0/9XY0/EX9E/EXA1: через одну инструкцию
+};
+
+struct Edge {
+    uint16_t target;
+    EdgeKind kind;
+};
+
+struct BasicBlock {
+    uint16_t start = 0;
+    uint16_t end = 0; // Адрес после последней инструкции
+    std::vector<Edge> successors;
+    bool returns = false; // Кончается на 00EE
+    bool computed = false; // Кончается на BNNN: куда дальше, статически не известно
+    bool invalid = false; // Кончается инструкцией, на которой ядро упадёт
+};
+
+// Статический разбор ROM: рекурсивный обход от точки входа по 1NNN/2NNN/00EE и пропускам.
+// Вызов считается возвращающимся. Переходы BNNN не разворачиваются - только отмечаются.
+// I отслеживается в пределах прямого прохода: после ANNN обращения DXYN/FX33/FX55/FX65 размечают данные.
+struct ProgramAnalysis {
+    uint16_t entry = 0x200;
+    uint8_t bytes[4096] = {}; // Флаги byte_* по адресам
+    std::vector<BasicBlock> blocks; // По возрастанию start
+    std::vector<uint16_t> subroutines; // Цели 2NNN, по возрастанию
+    std::vector<uint16_t> computed_jumps; // Адреса инструкций BNNN
+    bool overlapping = false; // Есть инструкция, начинающаяся внутри другой
+
+    const BasicBlock* blockAt(uint16_t start) const; // Блок, начинающийся ровно с start, или nullptr
+    bool isSubroutine(uint16_t address) const;
+};
+
+// memory - все 4 Кб машины (например, Chip8::getState().memory после loadROM)
+void analyzeProgram(const uint8_t* memory, uint16_t entry, ProgramAnalysis& analysis);
+
+// Листинг [start, end): блоки с метками, недостижимые байты и данные - строками DB
+void writeListing(FILE* out, const uint8_t* memory, const ProgramAnalysis& analysis, uint16_t start, uint16_t end);
+// Граф потока управления для Graphviz: узел - блок, ребро - EdgeKind
+void writeDot(FILE* out, const uint8_t* memory, const ProgramAnalysis& analysis);
+
+#endif //DISASM_H
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "chip8.h"
+#include "disasm.h"
+#include "mapped_file.h"
+
+// Дизассемблер ROM с разбором потока управления: листинг с метками блоков или граф для Graphviz
+int main(int argc, char *argv[]) {
+    const char *path = nullptr;
+    bool dot = false;
+    uint16_t entry = 0x200;
+    bool usage = false;
+    for (int i = 1; i < argc && !usage; ++i) {
+        if (!strcmp(argv[i], "--dot"))
+            dot = true;
+        else if (!strcmp(argv[i], "--entry") && i + 1 < argc)
+            entry = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 16) & 0xFFF);
+        else if (argv[i][0] != '-' && !path)
+            path = argv[i];
+        else
+            usage = true;
+    }
+
+    if (usage || !path) {
+        fprintf(stderr, "Usage: chip8-disasm <rom> [--dot] [--entry ADDR]\n"
+                "Prints a listing of the ROM with basic blocks from the control-flow graph,\n"
+                "or the graph itself in Graphviz format with --dot (chip8-disasm rom --dot | dot -Tsvg).\n");
+        return 1;
+    }
+
+    MappedFile rom;
+    if (!rom.open(path)) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+    // Лишнее за концом памяти loadROM отрежет, листинг - тоже
+    const size_t size = std::min<size_t>(rom.size(), 4096 - 0x200);
+
+    // Память как у машины после загрузки: шрифт тоже на месте, вдруг код прыгает туда
+    Chip8 chip8;
+    chip8.initialize();
+    if (!chip8.loadROM(rom.data(), rom.size())) {
+        fprintf(stderr, "%s is empty\n", path);
+        return 1;
+    }
+    const uint8_t *memory = chip8.getState().memory;
+
+    std::unique_ptr<ProgramAnalysis> analysis(new ProgramAnalysis());
+    analyzeProgram(memory, entry, *analysis);
+    if (dot)
+        writeDot(stdout, memory, *analysis);
+    else
+        writeListing(stdout, memory, *analysis, 0x200, static_cast<uint16_t>(0x200 + size));
+    return 0;
+}
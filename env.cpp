@@ -0,0 +1,173 @@
+#include "env.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static size_t alignTo64(const size_t offset) {
+    return (offset + 63) & ~static_cast<size_t>(63);
+}
+
+EnvLayout::EnvLayout(const size_t count) {
+    observations = 0;
+    rewards = alignTo64(observations + count * observation_size);
+    dones = alignTo64(rewards + count * sizeof(float));
+    size = alignTo64(dones + count);
+}
+
+VecEnv::VecEnv(const EnvConfig &config, const size_t count)
+    : config(config), engine(count), seeds(count), scores(count), frames(count), done(count) {
+    engine.setQuirks(config.quirks);
+    for (size_t lane = 0; lane < count; ++lane)
+        engine.machine(lane).setRngMode(config.rng_mode); // Режим - не часть состояния, сбросы его не трогают
+    if (config.cycles_per_frame)
+        engine.setCyclesPerFrame(config.cycles_per_frame);
+
+    // ROM читается с диска один раз, дальше все сбросы идут от снимка
+    Chip8 &first = engine.machine(0);
+    first.initialize();
+    loaded = first.loadROM(config.rom.c_str());
+    initial = first.getState();
+    if (loaded)
+        reset(nullptr);
+}
+
+VecEnv::~VecEnv() {
+#ifndef _WIN32
+    if (shared_memory) {
+        munmap(shared_memory, shared_size);
+        shm_unlink(shared_name.c_str());
+    }
+#endif
+}
+
+bool VecEnv::mapSharedMemory(const char *name) {
+#ifdef _WIN32
+    std::cout << "Shared memory is not supported on this platform" << std::endl;
+    return false;
+#else
+    const EnvLayout layout(size());
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(layout.size)) != 0) {
+        std::cout << "Failed to create shared memory " << name << std::endl;
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    void *memory = mmap(nullptr, layout.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // Отображение держит сегмент и без дескриптора
+    if (memory == MAP_FAILED) {
+        std::cout << "Failed to map shared memory " << name << std::endl;
+        return false;
+    }
+
+    if (shared_memory) {
+        munmap(shared_memory, shared_size);
+        if (shared_name != name)
+            shm_unlink(shared_name.c_str());
+    }
+    shared_memory = memory;
+    shared_size = layout.size;
+    shared_name = name;
+
+    uint8_t *base = static_cast<uint8_t *>(memory);
+    buffers.observations = base + layout.observations;
+    buffers.rewards = reinterpret_cast<float *>(base + layout.rewards);
+    buffers.dones = base + layout.dones;
+    for (size_t lane = 0; lane < size(); ++lane)
+        writeObservation(lane);
+    return true;
+#endif
+}
+
+double VecEnv::score(const size_t lane) const {
+    const uint8_t *memory = engine.machine(lane).getState().memory;
+    double total = 0;
+    for (const RewardSource &source : config.rewards) {
+        uint64_t value = 0;
+        for (uint8_t i = 0; i < source.length && i < 8; ++i) {
+            const uint8_t byte = memory[(source.address + i) & 0xFFF];
+            if (source.format == RewardSource::Format::Digits)
+                value = value * 10 + byte % 10;
+            else
+                value = value << 8 | byte;
+        }
+        total += static_cast<double>(value) * source.scale;
+    }
+    return total;
+}
+
+void VecEnv::writeObservation(const size_t lane) {
+    if (buffers.observations)
+        memcpy(buffers.observations + lane * observation_size, engine.machine(lane).getState().gfx, observation_size);
+}
+
+void VecEnv::resetLane(const size_t lane, const uint32_t seed) {
+    engine.machine(lane).reset(initial, seed);
+    engine.gatherReloaded(lane);
+
+    seeds[lane] = seed;
+    scores[lane] = score(lane);
+    frames[lane] = 0;
+    done[lane] = 0;
+}
+
+bool VecEnv::reset(const uint32_t *lane_seeds) {
+    if (!loaded)
+        return false;
+
+    for (size_t lane = 0; lane < size(); ++lane) {
+        resetLane(lane, lane_seeds ? lane_seeds[lane] : static_cast<uint32_t>(lane));
+
+        writeObservation(lane);
+        if (buffers.rewards)
+            buffers.rewards[lane] = 0;
+        if (buffers.dones)
+            buffers.dones[lane] = 0;
+    }
+    // Полный gather заново проверяет, что код у всех полос общий
+    engine.gather();
+    return true;
+}
+
+void VecEnv::step(const uint16_t *actions, const uint32_t frameskip) {
+    if (!loaded)
+        return;
+
+    const size_t count = size();
+    for (size_t lane = 0; lane < count; ++lane) {
+        if (done[lane])
+            resetLane(lane, seeds[lane] + static_cast<uint32_t>(count));
+        for (uint8_t key = 0; key < 16; ++key)
+            engine.setKey(lane, key, actions[lane] >> key & 1);
+    }
+
+    for (uint32_t frame = 0; frame < frameskip; ++frame)
+        engine.runFrame();
+
+    for (size_t lane = 0; lane < count; ++lane) {
+        const Chip8 &chip8 = engine.machine(lane);
+        frames[lane] += frameskip;
+
+        const double now = score(lane);
+        const float reward = static_cast<float>(now - scores[lane]);
+        scores[lane] = now;
+
+        // Упавшая полоса стоит, ждать от неё нечего - эпизод окончен
+        done[lane] = chip8.getFault() != Fault::None
+                     || (config.max_frames && frames[lane] >= config.max_frames)
+                     || (config.done_on_value && chip8.getState().memory[config.done_address & 0xFFF] == config.done_value);
+
+        writeObservation(lane);
+        if (buffers.rewards)
+            buffers.rewards[lane] = reward;
+        if (buffers.dones)
+            buffers.dones[lane] = done[lane];
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef ENV_H
+#define ENV_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lockstep.h"
+
+// Награда - изменение числа в памяти за шаг, умноженное на scale
+struct RewardSource {
+    enum class Format : uint8_t {
+        Binary, // Беззнаковое число, старший байт первым
+        Digits, // По десятичной цифре в байте, старшая первой - так пишет FX33
+    };
+
+    uint16_t address = 0;
+    uint8_t length = 1; // Байт (для Digits - цифр), не больше 8
+    Format format = Format::Binary;
+    float scale = 1;
+};
+
+struct EnvConfig {
+    std::string rom;
+    Quirks quirks;
+    RngMode rng_mode = RngMode::Xorshift;
+    uint32_t cycles_per_frame = 0; // 0 - значение ядра по умолчанию
+    std::vector<RewardSource> rewards;
+    uint64_t max_frames = 0; // Эпизод обрывается после стольких кадров; 0 - без ограничения
+    // Эпизод кончается, когда memory[done_address] == done_value (например, счётчик жизней дошёл до нуля)
+    bool done_on_value = false;
+    uint16_t done_address = 0;
+    uint8_t done_value = 0;
+};
+
+// Куда step() пишет результат. Буферы принадлежат вызывающему, среда их только заполняет.
+struct EnvBuffers {
+    uint8_t *observations = nullptr; // [среда][32][64], 0 или 1 на пиксель
+    float *rewards = nullptr; // [среда]
+    uint8_t *dones = nullptr; // [среда]
+};
+
+constexpr size_t observation_size = sizeof(Chip8State::gfx);
+
+// Раскладка общего сегмента: наблюдения, награды, флаги; каждый кусок выровнен на 64 байта
+struct EnvLayout {
+    size_t observations = 0;
+    size_t rewards = 0;
+    size_t dones = 0;
+    size_t size = 0;
+
+    explicit EnvLayout(size_t count);
+};
+
+// Пачка сред для обучения поверх LockstepEngine. Действие - маска нажатых клавиш (бит k - клавиша k).
+// Среда, закончившая эпизод, сбрасывается в начале следующего step() с сидом seed + count.
+class VecEnv {
+    EnvConfig config;
+    LockstepEngine engine;
+    EnvBuffers buffers;
+    Chip8State initial; // Сразу после загрузки ROM: сброс эпизода - копия отсюда
+    std::vector<uint32_t> seeds;
+    std::vector<double> scores; // Значение наград на конец прошлого шага
+    std::vector<uint64_t> frames; // Кадров с начала эпизода
+    std::vector<uint8_t> done; // Своя копия: буфер вызывающего среда не читает
+    bool loaded = false;
+
+    void *shared_memory = nullptr;
+    size_t shared_size = 0;
+    std::string shared_name;
+
+    void resetLane(size_t lane, uint32_t seed);
+    double score(size_t lane) const;
+    void writeObservation(size_t lane);
+
+public:
+    VecEnv(const EnvConfig &config, size_t count);
+    ~VecEnv();
+    VecEnv(const VecEnv &) = delete;
+    VecEnv &operator=(const VecEnv &) = delete;
+
+    bool isLoaded() const { return loaded; } // false - ROM не открылся
+    size_t size() const { return engine.size(); }
+
+    void setBuffers(const EnvBuffers &target) { buffers = target; }
+    // Создаёт POSIX shared memory name (shm_open) с раскладкой EnvLayout и пишет прямо туда.
+    // Сегмент удаляется в деструкторе.
+    bool mapSharedMemory(const char *name);
+    const EnvBuffers &getBuffers() const { return buffers; }
+
+    // seeds - по одному на среду; nullptr - сиды 0..count-1. Пишет наблюдения, награды 0, флаги 0.
+    bool reset(const uint32_t *seeds);
+    // actions - по маске клавиш на среду; frameskip кадров с этими клавишами
+    void step(const uint16_t *actions, uint32_t frameskip);
+
+    LockstepEngine &getEngine() { return engine; }
+};
+
+#endif //ENV_H
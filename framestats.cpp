@@ -0,0 +1,106 @@
+#include "framestats.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <iostream>
+
+static constexpr double frame_budget_ms = 1000.0 / 60;
+
+void DurationHistogram::add(const double ms) {
+    const double clamped = ms > 0 ? ms : 0;
+    const unsigned bucket = static_cast<unsigned>(clamped / bucket_ms);
+    ++buckets[bucket < bucket_count ? bucket : bucket_count];
+    ++count;
+    sum_ms += clamped;
+    if (clamped > max_ms)
+        max_ms = clamped;
+}
+
+double DurationHistogram::percentile(const double p) const {
+    if (!count)
+        return 0;
+    const double target = p * static_cast<double>(count);
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < bucket_count; ++i) {
+        seen += buckets[i];
+        if (static_cast<double>(seen) >= target)
+            return std::min((i + 1) * bucket_ms, max_ms);
+    }
+    return max_ms;
+}
+
+int64_t FrameStats::now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin).count();
+}
+
+void FrameStats::startFrame() {
+    for (int64_t &stage : current.stages)
+        stage = -1;
+    current.input = -1;
+    current.frame_ms = -1;
+    current.latency_ms = -1;
+}
+
+void FrameStats::mark(const FrameStage stage) {
+    const int64_t time = now();
+    current.stages[static_cast<unsigned>(stage)] = time;
+    if (stage != FrameStage::Present)
+        return;
+
+    if (last_present >= 0) {
+        current.frame_ms = static_cast<float>((time - last_present) / 1000.0);
+        frame_time.add(current.frame_ms);
+        jitter.add(std::fabs(current.frame_ms - frame_budget_ms));
+    }
+    last_present = time;
+    if (current.input >= 0) {
+        current.latency_ms = static_cast<float>((time - current.input) / 1000.0);
+        latency.add(current.latency_ms);
+    }
+
+    if (keep_records && records.size() < max_records)
+        records.push_back(current);
+    history[frames % history_size] = current;
+    ++frames;
+    startFrame();
+}
+
+void FrameStats::input(const uint32_t age_ms) {
+    int64_t time = now() - static_cast<int64_t>(age_ms) * 1000;
+    if (time < 0)
+        time = 0; // Событие старше самих замеров
+    if (current.input < 0 || time < current.input)
+        current.input = time;
+}
+
+bool FrameStats::writeCsv(const char *filename) const {
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        std::cout << "Failed to write frame stats " << filename << std::endl;
+        return false;
+    }
+
+    fprintf(out, "frame,poll_us,emulate_start_us,emulate_end_us,upload_us,present_us,input_us,frame_ms,latency_ms\n");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const FrameRecord &record = records[i];
+        fprintf(out, "%zu", i);
+        for (const int64_t stage : record.stages)
+            fprintf(out, ",%" PRId64, stage);
+        fprintf(out, ",%" PRId64 ",%.3f,%.3f\n", record.input, record.frame_ms, record.latency_ms);
+    }
+    fclose(out);
+    return true;
+}
+
+void FrameStats::printSummary(FILE *out) const {
+    const struct {
+        const char *name;
+        const DurationHistogram &histogram;
+    } rows[] = {{"frame_time", frame_time}, {"jitter", jitter}, {"input_latency", latency}};
+    for (const auto &row : rows) {
+        fprintf(out, "%s count=%" PRIu64 " mean_ms=%.2f p50_ms=%.1f p95_ms=%.1f p99_ms=%.1f max_ms=%.2f\n", row.name,
+                row.histogram.getCount(), row.histogram.getMean(), row.histogram.percentile(0.5),
+                row.histogram.percentile(0.95), row.histogram.percentile(0.99), row.histogram.getMax());
+    }
+}
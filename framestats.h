@@ -0,0 +1,88 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Точки главного цикла фронтенда, в порядке прохождения
+enum class FrameStage : uint8_t {
+    Poll, // Начало опроса событий
+    EmulateStart, // Пачка инструкций кадра (или шаг перемотки)
+    EmulateEnd,
+    Upload, // Кадр ушёл в текстуру
+    Present, // SDL_RenderPresent вернулся - кадр закрыт
+};
+
+constexpr unsigned frame_stage_count = 5;
+
+// Гистограмма длительностей: корзины по 0.1 мс до 100 мс, всё дольше - в последней
+class DurationHistogram {
+    static constexpr unsigned bucket_count = 1000;
+    static constexpr double bucket_ms = 0.1;
+
+    uint32_t buckets[bucket_count + 1] = {};
+    uint64_t count = 0;
+    double sum_ms = 0;
+    double max_ms = 0;
+
+public:
+    void add(double ms);
+    uint64_t getCount() const { return count; }
+    double getMean() const { return count ? sum_ms / static_cast<double>(count) : 0; }
+    double getMax() const { return max_ms; }
+    // Верхняя граница корзины с p-й долей (0..1) замеров, не больше максимума
+    double percentile(double p) const;
+};
+
+struct FrameRecord {
+    int64_t stages[frame_stage_count]; // Мкс от создания FrameStats, -1 - точки не было
+    int64_t input; // Самое раннее событие ввода, показанное этим кадром; -1 - не было
+    float frame_ms; // От прошлого Present; -1 у первого кадра
+    float latency_ms; // От input до Present; -1 без ввода
+};
+
+// Замеры главного цикла: метки времени каждого кадра, гистограммы времени кадра, неровности темпа
+// (отклонение от 1/60 с) и задержки от события ввода до Present. Пара вызовов steady_clock на метку.
+class FrameStats {
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t max_records = 60 * 60 * 60; // Для CSV: час при 60 кадрах, дальше только гистограммы
+    static constexpr size_t history_size = 128; // Последние кадры для оверлея
+
+    Clock::time_point origin = Clock::now();
+    bool keep_records; // Для CSV; без него память на записи не тратится
+    std::vector<FrameRecord> records;
+    FrameRecord history[history_size];
+    uint64_t frames = 0;
+    FrameRecord current;
+    int64_t last_present = -1;
+    DurationHistogram frame_time;
+    DurationHistogram jitter;
+    DurationHistogram latency;
+
+    int64_t now() const;
+    void startFrame();
+
+public:
+    // keep_records - копить записи кадров для writeCsv; гистограммы и история для оверлея ведутся всегда
+    explicit FrameStats(bool keep_records = false) : keep_records(keep_records) { startFrame(); }
+
+    void mark(FrameStage stage); // Present закрывает кадр
+    // Событие ввода, которое SDL получил age_ms назад; задержка считается до ближайшего Present
+    void input(uint32_t age_ms);
+
+    uint64_t getFrames() const { return frames; }
+    // back-й кадр с конца, back < getHistorySize()
+    const FrameRecord& recent(size_t back) const { return history[(frames - 1 - back) % history_size]; }
+    size_t getHistorySize() const { return frames < history_size ? static_cast<size_t>(frames) : history_size; }
+    const DurationHistogram& getFrameTime() const { return frame_time; }
+    const DurationHistogram& getJitter() const { return jitter; }
+    const DurationHistogram& getLatency() const { return latency; }
+
+    // По строке на кадр: метки в мкс, время кадра и задержка ввода в мс; только с keep_records
+    bool writeCsv(const char* filename) const;
+    // Процентили трёх гистограмм, по строке на каждую
+    void printSummary(FILE* out) const;
+};
+
+#endif //FRAMESTATS_H
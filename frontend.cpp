@@ -0,0 +1,133 @@
+#include "frontend.h"
+
+#include "output.h"
+
+Frontend::~Frontend() {
+    if (audio)
+        SDL_CloseAudioDevice(audio);
+    if (texture)
+        SDL_DestroyTexture(texture);
+    if (renderer)
+        SDL_DestroyRenderer(renderer);
+    if (window)
+        SDL_DestroyWindow(window);
+    SDL_Quit();
+}
+
+void Frontend::setupGraphics(const int scale, const bool audio_enabled) {
+    SDL_Init(audio_enabled ? SDL_INIT_VIDEO | SDL_INIT_AUDIO : SDL_INIT_VIDEO);
+    window = SDL_CreateWindow("CHIP-8", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 64 * scale, 32 * scale, 0);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, 64, 32);
+    if (!audio_enabled)
+        return; // updateSound молчит без устройства
+
+    // Устройство открываем один раз: раньше оно открывалось на каждый писк и блокировало кадр на 100 мс
+    SDL_AudioSpec want{}, have{};
+    want.freq = 44100;
+    want.format = AUDIO_S16SYS;
+    want.channels = 1;
+    want.samples = 512;
+    want.callback = nullptr;
+
+    audio = SDL_OpenAudioDevice(nullptr, 0, &want, &have, 0);
+    if (audio) {
+        audio_freq = have.freq;
+        SDL_PauseAudioDevice(audio, 0);
+    }
+}
+
+void Frontend::renderGraphics(const Chip8 &chip8, FrameStats *stats) const {
+    const uint8_t *gfx = chip8.getState().gfx;
+    uint32_t pixels[64 * 32];
+    framebufferToPixels(gfx, pixels, on_color, off_color);
+
+    SDL_UpdateTexture(texture, nullptr, pixels, 64 * sizeof(uint32_t));
+    if (stats)
+        stats->mark(FrameStage::Upload);
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    if (stats && overlay)
+        drawOverlay(*stats);
+    SDL_RenderPresent(renderer);
+    if (stats)
+        stats->mark(FrameStage::Present);
+}
+
+void Frontend::drawOverlay(const FrameStats &stats) const {
+    int width, height;
+    SDL_GetRendererOutputSize(renderer, &width, &height);
+    const int bar_width = width / 128 > 0 ? width / 128 : 1;
+    const double pixels_per_ms = height / 50.0; // Шкала до 50 мс, бюджет кадра - треть высоты
+
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    const SDL_Rect background = {0, 0, width, height};
+    SDL_RenderFillRect(renderer, &background);
+
+    // Столбик на кадр, новые справа: зелёный - уложились в 1/60 с, жёлтый - в две, красный - хуже
+    for (size_t back = 0; back < stats.getHistorySize(); ++back) {
+        const FrameRecord &record = stats.recent(back);
+        const int x = width - static_cast<int>(back + 1) * bar_width;
+        if (x < 0)
+            break;
+        if (record.frame_ms >= 0) {
+            const int bar = static_cast<int>(record.frame_ms * pixels_per_ms);
+            if (record.frame_ms <= 17.5)
+                SDL_SetRenderDrawColor(renderer, 0, 200, 0, 255);
+            else if (record.frame_ms <= 34)
+                SDL_SetRenderDrawColor(renderer, 230, 200, 0, 255);
+            else
+                SDL_SetRenderDrawColor(renderer, 230, 0, 0, 255);
+            const SDL_Rect rect = {x, height - bar, bar_width > 1 ? bar_width - 1 : 1, bar};
+            SDL_RenderFillRect(renderer, &rect);
+        }
+        // Задержка ввода - синяя метка на своей высоте
+        if (record.latency_ms >= 0) {
+            SDL_SetRenderDrawColor(renderer, 60, 140, 255, 255);
+            const SDL_Rect mark = {x, height - static_cast<int>(record.latency_ms * pixels_per_ms) - 2, bar_width, 4};
+            SDL_RenderFillRect(renderer, &mark);
+        }
+    }
+
+    // Линии 1/60 и 2/60 с
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    for (int frames = 1; frames <= 2; ++frames) {
+        const SDL_Rect line = {0, height - static_cast<int>(frames * 1000.0 / 60 * pixels_per_ms), width, 1};
+        SDL_RenderFillRect(renderer, &line);
+    }
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+}
+
+void Frontend::updateSound(const Chip8 &chip8) {
+    if (!audio || !chip8.isSoundActive())
+        return;
+
+    // Держим в очереди не больше двух кадров, иначе писк тянется после остановки таймера
+    const int frame_samples = audio_freq / 60;
+    if (SDL_GetQueuedAudioSize(audio) > static_cast<Uint32>(frame_samples * 2 * sizeof(int16_t)))
+        return;
+
+    int16_t buffer[4096];
+    const int count = frame_samples < 4096 ? frame_samples : 4096;
+    squareWave(buffer, count, audio_freq / 440 / 2, tone_phase);
+
+    SDL_QueueAudio(audio, buffer, count * sizeof(int16_t));
+}
+
+void Frontend::setKeys(const char (&host_keys)[16]) {
+    for (unsigned k = 0; k < 16; ++k) {
+        if (host_keys[k])
+            keys[k] = host_keys[k];
+    }
+}
+
+void Frontend::handleKeyEvent(Chip8 &chip8, const SDL_Event &event, const uint64_t cycle) {
+    // Коды SDL для букв и цифр - это сами символы
+    for (uint8_t k = 0; k < 16; ++k) {
+        if (event.key.keysym.sym == static_cast<unsigned char>(keys[k])) {
+            chip8.queueKeyEvent(k, event.type == SDL_KEYDOWN, cycle);
+            return;
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+#include <SDL2/SDL.h>
+#include <cstdint>
+
+#include "chip8.h"
+#include "framestats.h"
+
+// Окно, звук и клавиатура на SDL. Ядро (chip8core) про SDL ничего не знает.
+class Frontend {
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    SDL_AudioDeviceID audio = 0;
+    int audio_freq = 44100;
+    uint32_t tone_phase = 0; // Чтобы меандр не рвался между кадрами
+    bool overlay = false;
+    uint32_t off_color = 0x00000000; // RGBA8888
+    uint32_t on_color = 0xFFFFFFFF;
+    char keys[16] = {'x', '1', '2', '3', 'q', 'w', 'e', 'a', 's', 'd', 'z', 'c', '4', 'r', 'f', 'v'}; // Для 0-F
+
+    void drawOverlay(const FrameStats& stats) const;
+
+public:
+    ~Frontend();
+
+    // Окно 64x32, каждый пиксель - квадрат scale x scale. Без audio звуковая подсистема SDL не поднимается вовсе.
+    void setupGraphics(int scale = 10, bool audio_enabled = true);
+    // stats - отметить Upload и Present и, если включён оверлей, нарисовать его поверх кадра
+    void renderGraphics(const Chip8& chip8, FrameStats* stats = nullptr) const;
+    // Оверлей: столбики времени последних кадров и задержки ввода (F1)
+    void toggleOverlay() { overlay = !overlay; }
+    void setPalette(uint32_t off, uint32_t on) { off_color = off; on_color = on; }
+    // Клавиши хоста (символ на клавиатуре) для клавиш CHIP-8 0-F; 0 оставляет прежнюю
+    void setKeys(const char (&host_keys)[16]);
+    // Раз в кадр: подкладывает в очередь звука кадр меандра, пока звуковой таймер идёт
+    void updateSound(const Chip8& chip8);
+    // Ставит событие клавиатуры в очередь; оно применится перед циклом cycle
+    void handleKeyEvent(Chip8& chip8, const SDL_Event& event, uint64_t cycle);
+};
+
+#endif //FRONTEND_H
@@ -0,0 +1,78 @@
+// Цель для libFuzzer: вход - ROM и сценарий клавиш, прогон ограничен по циклам.
+// Формат входа: u16 LE длина ROM, байты ROM, дальше пары (циклов с прошлого события, клавиша | нажата << 7).
+// Сборка: cmake -DCHIP8_FUZZ=ON с clang, запуск: ./chip8-fuzz corpus/
+#include <cstddef>
+#include <cstdint>
+
+#include "chip8.h"
+#include "profiler.h"
+
+static constexpr uint32_t max_frames = 2000; // По 10 циклов при скорости по умолчанию
+static constexpr size_t max_events = 128; // Меньше ёмкости InputQueue: события не теряются
+
+// Дополнительная обратная связь: какие адреса гостя выполнялись и какие пары инструкций шли подряд.
+// libFuzzer сам подхватывает счётчики из этой секции (только ELF).
+#if defined(__linux__)
+#define EXTRA_COUNTERS __attribute__((section("__libfuzzer_extra_counters")))
+#else
+#define EXTRA_COUNTERS
+#endif
+
+EXTRA_COUNTERS static uint8_t pc_counters[4096];
+EXTRA_COUNTERS static uint8_t edge_counters[opcode_class_count * opcode_class_count];
+
+// Хуки для Chip8::runCyclesWith: заполняют счётчики после каждой инструкции
+struct FeedbackHooks {
+    uint16_t pc = 0;
+    unsigned previous = 0;
+
+    bool beforeInstruction(const Chip8State &state) {
+        pc = state.program_counter & 0xFFF;
+        return true;
+    }
+
+    bool afterInstruction(const Chip8State &state) {
+        const unsigned current = opcodeClass(state.opcode);
+        ++pc_counters[pc];
+        ++edge_counters[previous * opcode_class_count + current];
+        previous = current;
+        return true;
+    }
+};
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    // Один экземпляр на весь процесс, между входами - сброс к снимку без ROM
+    static Chip8 chip8;
+    static Chip8State empty;
+    static bool ready = false;
+    if (!ready) {
+        chip8.initialize();
+        empty = chip8.getState();
+        ready = true;
+    }
+
+    if (size < 2)
+        return 0;
+    size_t rom_size = data[0] | data[1] << 8;
+    data += 2;
+    size -= 2;
+    if (rom_size > size)
+        rom_size = size;
+
+    chip8.reset(empty, 0);
+    if (!chip8.loadROM(data, rom_size))
+        return 0;
+    data += rom_size;
+    size -= rom_size;
+
+    uint64_t cycle = 0;
+    for (size_t i = 0; i + 1 < size && i / 2 < max_events; i += 2) {
+        cycle += data[i];
+        chip8.queueKeyEvent(data[i + 1] & 0x0F, (data[i + 1] & 0x80) != 0, cycle);
+    }
+
+    FeedbackHooks hooks;
+    for (uint32_t frame = 0; frame < max_frames && chip8.getFault() == Fault::None; ++frame)
+        chip8.runFrameWith(hooks);
+    return 0;
+}
@@ -0,0 +1,580 @@
+#include "gdbstub.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static constexpr unsigned register_count = 19; // V0-VF, I, PC, SP
+
+static const char target_xml[] =
+        "<?xml version=\"1.0\"?>"
+        "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+        "<target version=\"1.0\"><feature name=\"org.chip8.cpu\">"
+        "<reg name=\"v0\" bitsize=\"8\" type=\"uint8\"/><reg name=\"v1\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"v2\" bitsize=\"8\" type=\"uint8\"/><reg name=\"v3\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"v4\" bitsize=\"8\" type=\"uint8\"/><reg name=\"v5\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"v6\" bitsize=\"8\" type=\"uint8\"/><reg name=\"v7\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"v8\" bitsize=\"8\" type=\"uint8\"/><reg name=\"v9\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"va\" bitsize=\"8\" type=\"uint8\"/><reg name=\"vb\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"vc\" bitsize=\"8\" type=\"uint8\"/><reg name=\"vd\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"ve\" bitsize=\"8\" type=\"uint8\"/><reg name=\"vf\" bitsize=\"8\" type=\"uint8\"/>"
+        "<reg name=\"i\" bitsize=\"16\" type=\"data_ptr\"/>"
+        "<reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>"
+        "<reg name=\"sp\" bitsize=\"8\" type=\"uint8\"/>"
+        "</feature></target>";
+
+static unsigned registerSize(const unsigned reg) {
+    return reg == 16 || reg == 17 ? 2 : 1;
+}
+
+static uint16_t readRegister(const Chip8State &state, const unsigned reg) {
+    if (reg < 16)
+        return state.V[reg];
+    if (reg == 16)
+        return state.index;
+    if (reg == 17)
+        return state.program_counter;
+    return state.stack_pointer;
+}
+
+static void writeRegister(Chip8State &state, const unsigned reg, const uint16_t value) {
+    if (reg < 16)
+        state.V[reg] = static_cast<uint8_t>(value);
+    else if (reg == 16)
+        state.index = value;
+    else if (reg == 17) {
+        state.program_counter = value & 0xFFF;
+        state.fault = static_cast<uint8_t>(Fault::None); // Новый PC - шанс уйти с упавшей инструкции
+    } else
+        state.stack_pointer = value < 16 ? value : 15;
+}
+
+static void appendHex(std::string &out, uint32_t value, const unsigned bytes) {
+    static const char digits[] = "0123456789abcdef";
+    for (unsigned i = 0; i < bytes; ++i, value >>= 8) { // Little-endian
+        out += digits[(value >> 4) & 0xF];
+        out += digits[value & 0xF];
+    }
+}
+
+static int hexDigit(const char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// bytes байт little-endian из text; false - не хватило цифр
+static bool parseHex(const char *&text, const unsigned bytes, uint16_t &value) {
+    value = 0;
+    for (unsigned i = 0; i < bytes; ++i) {
+        const int high = hexDigit(text[0]);
+        const int low = high < 0 ? -1 : hexDigit(text[1]);
+        if (low < 0)
+            return false;
+        value |= static_cast<uint16_t>((high << 4 | low) << (8 * i));
+        text += 2;
+    }
+    return true;
+}
+
+// "addr,length" в начале text
+static bool parseRange(const char *&text, unsigned long &address, unsigned long &length) {
+    char *end = nullptr;
+    address = strtoul(text, &end, 16);
+    if (end == text || *end != ',')
+        return false;
+    text = end + 1;
+    length = strtoul(text, &end, 16);
+    if (end == text)
+        return false;
+    text = end;
+    return true;
+}
+
+static const char *faultSignal(const Fault fault) {
+    return fault == Fault::UnknownOpcode ? "S04" : "S0b"; // SIGILL, остальное - SIGSEGV
+}
+
+#ifdef _WIN32
+
+bool GdbStub::open(uint16_t) {
+    std::cout << "The gdb server is not supported on this platform" << std::endl;
+    return false;
+}
+
+void GdbStub::close() {}
+
+void GdbStub::serve() {}
+
+void GdbStub::exchange(int) {}
+
+void GdbStub::reply(const std::string &) {}
+
+#else
+
+// Труба пробуждения: байт - "есть новости", содержимое не важно
+static void poke(const int fd) {
+    const char byte = 0;
+    const ssize_t written = write(fd, &byte, 1);
+    (void) written; // Труба полна - поток и так проснётся
+}
+
+static void drain(const int fd) {
+    char buffer[64];
+    const ssize_t got = read(fd, buffer, sizeof(buffer));
+    (void) got;
+}
+
+bool GdbStub::open(const uint16_t port) {
+    close();
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cout << "Failed to create a socket for gdb" << std::endl;
+        return false;
+    }
+    const int yes = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Только локально: протокол без аутентификации
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 1) != 0
+        || pipe(wake) != 0) {
+        std::cout << "Failed to listen for gdb on port " << port << std::endl;
+        ::close(listener);
+        listener = -1;
+        return false;
+    }
+
+    stopping = false;
+    halted = true;
+    killed = false;
+    server = std::thread(&GdbStub::serve, this);
+    return true;
+}
+
+void GdbStub::close() {
+    if (listener < 0)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    poke(wake[1]);
+    server.join();
+    ::close(listener);
+    ::close(wake[0]);
+    ::close(wake[1]);
+    listener = wake[0] = wake[1] = -1;
+}
+
+void GdbStub::serve() {
+    for (;;) {
+        pollfd fds[2] = {{listener, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0)
+            continue;
+        if (fds[1].revents) {
+            drain(wake[0]);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping)
+                return;
+            replies.clear(); // Некому отправлять
+            continue;
+        }
+
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            attach = true;
+            replies.clear();
+            pending = true;
+        }
+        changed.notify_all();
+
+        exchange(client);
+        ::close(client);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            requests.emplace_back(); // Отключение: поток эмуляции снимет точки и отпустит цель
+            pending = true;
+        }
+        changed.notify_all();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping)
+            return;
+    }
+}
+
+void GdbStub::exchange(const int client) {
+    std::string input;
+    for (;;) {
+        pollfd fds[2] = {{client, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0)
+            continue;
+
+        if (fds[1].revents) {
+            drain(wake[0]);
+            std::string out;
+            bool closing;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                out.swap(replies);
+                closing = stopping;
+            }
+            if (!out.empty() && send(client, out.data(), out.size(), MSG_NOSIGNAL) < 0)
+                return;
+            if (closing)
+                return;
+        }
+        if (!fds[0].revents)
+            continue;
+
+        char buffer[4096];
+        const ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            return;
+        input.append(buffer, static_cast<size_t>(received));
+
+        bool notify = false;
+        size_t position = 0;
+        while (position < input.size()) {
+            const char c = input[position];
+            if (c == '\x03') {
+                std::lock_guard<std::mutex> lock(mutex);
+                interrupt = true;
+                pending = true;
+                notify = true;
+                ++position;
+                continue;
+            }
+            if (c != '$') { // Подтверждения '+'/'-' и мусор между пакетами
+                ++position;
+                continue;
+            }
+
+            const size_t hash = input.find('#', position);
+            if (hash == std::string::npos || hash + 2 >= input.size())
+                break; // Пакет пришёл не целиком
+            const std::string payload = input.substr(position + 1, hash - position - 1);
+            unsigned sum = 0;
+            for (const char byte : payload)
+                sum += static_cast<uint8_t>(byte);
+            const int high = hexDigit(input[hash + 1]);
+            const int low = hexDigit(input[hash + 2]);
+            position = hash + 3;
+
+            const bool valid = high >= 0 && low >= 0 && static_cast<unsigned>(high << 4 | low) == (sum & 0xFF);
+            if (send(client, valid ? "+" : "-", 1, MSG_NOSIGNAL) < 0)
+                return;
+            if (valid) {
+                std::lock_guard<std::mutex> lock(mutex);
+                requests.push_back(payload);
+                pending = true;
+                notify = true;
+            }
+        }
+        input.erase(0, position);
+        if (notify)
+            changed.notify_all();
+    }
+}
+
+void GdbStub::reply(const std::string &payload) {
+    unsigned sum = 0;
+    for (const char byte : payload)
+        sum += static_cast<uint8_t>(byte);
+    char checksum[4];
+    snprintf(checksum, sizeof(checksum), "#%02x", sum & 0xFF);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        replies += '$';
+        replies += payload;
+        replies += checksum;
+    }
+    poke(wake[1]);
+}
+
+#endif
+
+void GdbStub::halt(const char *signal) {
+    halted = true;
+    stepping = false;
+    last_signal = signal;
+    reply(signal);
+}
+
+void GdbStub::detach() {
+    debugger.clearBreakpoints();
+    breakpoint_count = 0;
+    stepping = false;
+    halted = false;
+}
+
+void GdbStub::handle(const std::string &packet, Chip8 &chip8) {
+    if (packet.empty()) {
+        detach();
+        return;
+    }
+
+    const char *args = packet.c_str() + 1;
+    Chip8State state = chip8.getState();
+    switch (packet[0]) {
+        case '?':
+            reply(last_signal);
+            return;
+
+        case 'g': {
+            std::string out;
+            for (unsigned reg = 0; reg < register_count; ++reg)
+                appendHex(out, readRegister(state, reg), registerSize(reg));
+            reply(out);
+            return;
+        }
+
+        case 'G': {
+            for (unsigned reg = 0; reg < register_count; ++reg) {
+                uint16_t value;
+                if (!parseHex(args, registerSize(reg), value)) {
+                    reply("E01");
+                    return;
+                }
+                writeRegister(state, reg, value);
+            }
+            chip8.setState(state);
+            reply("OK");
+            return;
+        }
+
+        case 'p':
+        case 'P': {
+            char *end = nullptr;
+            const unsigned long reg = strtoul(args, &end, 16);
+            if (end == args || reg >= register_count) {
+                reply("E01");
+                return;
+            }
+            if (packet[0] == 'p') {
+                std::string out;
+                appendHex(out, readRegister(state, static_cast<unsigned>(reg)), registerSize(static_cast<unsigned>(reg)));
+                reply(out);
+                return;
+            }
+            const char *value_text = end + 1;
+            uint16_t value;
+            if (*end != '=' || !parseHex(value_text, registerSize(static_cast<unsigned>(reg)), value)) {
+                reply("E01");
+                return;
+            }
+            writeRegister(state, static_cast<unsigned>(reg), value);
+            chip8.setState(state);
+            reply("OK");
+            return;
+        }
+
+        case 'm':
+        case 'M': {
+            unsigned long address, length;
+            if (!parseRange(args, address, length) || address >= sizeof(state.memory)) {
+                reply("E01");
+                return;
+            }
+            if (length > sizeof(state.memory) - address)
+                length = sizeof(state.memory) - address;
+            if (packet[0] == 'm') {
+                std::string out;
+                for (unsigned long i = 0; i < length; ++i)
+                    appendHex(out, state.memory[address + i], 1);
+                reply(out);
+                return;
+            }
+            if (*args++ != ':') {
+                reply("E01");
+                return;
+            }
+            for (unsigned long i = 0; i < length; ++i) {
+                uint16_t byte;
+                if (!parseHex(args, 1, byte)) {
+                    reply("E01");
+                    return;
+                }
+                state.memory[address + i] = static_cast<uint8_t>(byte);
+            }
+            chip8.setState(state);
+            reply("OK");
+            return;
+        }
+
+        case 'c':
+        case 's':
+            // Ответ придёт, когда цель снова остановится
+            if (*args) {
+                writeRegister(state, 17, static_cast<uint16_t>(strtoul(args, nullptr, 16)));
+                chip8.setState(state);
+            }
+            if (packet[0] == 's') {
+                debugger.stepInto();
+                stepping = true;
+            }
+            halted = false;
+            return;
+
+        case 'Z':
+        case 'z': {
+            // Программные и аппаратные точки - одно и то же
+            if ((args[0] != '0' && args[0] != '1') || args[1] != ',') {
+                reply("");
+                return;
+            }
+            char *end = nullptr;
+            const uint16_t address = static_cast<uint16_t>(strtoul(args + 2, &end, 16) & 0xFFF);
+            const bool enable = packet[0] == 'Z';
+            if (debugger.hasBreakpoint(address) != enable) {
+                debugger.setBreakpoint(address, enable);
+                if (enable)
+                    ++breakpoint_count;
+                else
+                    --breakpoint_count;
+            }
+            reply("OK");
+            return;
+        }
+
+        case 'k':
+            killed = true;
+            halted = false;
+            return;
+
+        case 'D':
+            reply("OK");
+            detach();
+            detached = true;
+            return;
+
+        case 'H':
+            reply("OK"); // Поток один
+            return;
+
+        case 'q':
+            if (!packet.compare(0, 11, "qSupported:") || packet == "qSupported") {
+                reply("PacketSize=1000;qXfer:features:read+");
+            } else if (packet == "qAttached") {
+                reply("1");
+            } else if (!packet.compare(0, 31, "qXfer:features:read:target.xml:")) {
+                const char *range = packet.c_str() + 31;
+                unsigned long offset, length;
+                if (!parseRange(range, offset, length)) {
+                    reply("E01");
+                    return;
+                }
+                const size_t size = sizeof(target_xml) - 1;
+                if (offset >= size) {
+                    reply("l");
+                    return;
+                }
+                const std::string chunk(target_xml + offset, std::min<size_t>(length, size - offset));
+                reply((offset + chunk.size() < size ? "m" : "l") + chunk);
+            } else {
+                reply("");
+            }
+            return;
+
+        default:
+            reply(""); // Не поддерживается: gdb перейдёт на то, что есть
+            return;
+    }
+}
+
+void GdbStub::service(Chip8 &chip8) {
+    if (!halted && !pending.load(std::memory_order_acquire))
+        return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        pending = false;
+        if (attach) {
+            attach = false;
+            detached = false;
+            halted = true;
+            last_signal = "S05";
+        }
+        if (interrupt) {
+            interrupt = false;
+            if (!halted) {
+                lock.unlock();
+                halt("S02"); // SIGINT
+                lock.lock();
+            }
+        }
+        while (!requests.empty() && !killed) {
+            const std::string packet = std::move(requests.front());
+            requests.pop_front();
+            lock.unlock();
+            handle(packet, chip8);
+            lock.lock();
+        }
+        if (!halted || killed)
+            return;
+        changed.wait(lock, [this] { return attach || interrupt || !requests.empty(); });
+    }
+}
+
+uint64_t GdbStub::run(Chip8 &chip8, const uint64_t frames, const bool interactive) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::duration frame_period = std::chrono::microseconds(1000000 / 60);
+    Clock::time_point next_frame = Clock::now();
+
+    uint64_t done = 0;
+    while (interactive || done < frames) {
+        service(chip8);
+        if (killed || (interactive && detached))
+            break;
+        if (interactive) {
+            // Простояли в service (остановка в отладчике) - темп отсчитываем заново, без догоняния
+            const Clock::time_point now = Clock::now();
+            if (next_frame < now)
+                next_frame = now;
+            else
+                std::this_thread::sleep_until(next_frame);
+            next_frame += frame_period;
+        }
+
+        // Без точек и шага - обычный кадр; Debugger доигрывает и кадр, прерванный остановкой
+        if (breakpoint_count || stepping || debugger.getFrameCycles()) {
+            done += debugger.run(chip8, 1);
+            const StopReason reason = debugger.getStopReason();
+            if (reason != StopReason::None && reason != StopReason::Fault) {
+                halt("S05"); // SIGTRAP
+                continue;
+            }
+        } else {
+            chip8.runFrame();
+            ++done;
+        }
+        if (chip8.getFault() != Fault::None)
+            halt(faultSignal(chip8.getFault()));
+    }
+
+    if (!killed && !detached)
+        reply("W00"); // Кадры кончились: для gdb программа завершилась
+    return done;
+}
@@ -0,0 +1,70 @@
+#ifndef GDBSTUB_H
+#define GDBSTUB_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "chip8.h"
+#include "debugger.h"
+
+// Сервер GDB Remote Serial Protocol на 127.0.0.1: gdb, lldb и IDE подключаются через target remote.
+// Сетевой поток только принимает и отправляет пакеты. Разбирает их и трогает машину поток эмуляции,
+// в безопасной точке между кадрами (service). Пока отладчик ничего не просил, service - одно чтение
+// атомарного флага на кадр, а кадры идут обычным runFrame; с точками останова или шагом - через Debugger.
+// Регистры: V0-VF по байту, I и PC по два байта little-endian, SP - байт (описание - qXfer target.xml).
+// Пакеты: ? g G p P m M c s Z0/z0 (и Z1/z1) k D qSupported qAttached, Ctrl-C.
+class GdbStub {
+    // Только поток эмуляции
+    Debugger debugger;
+    uint32_t breakpoint_count = 0;
+    bool stepping = false;
+    bool halted = true; // Цель стоит с самого начала: ждём, пока подключатся и скажут continue
+    bool killed = false;
+    bool detached = false; // Пришёл D: в interactive-прогоне это конец сессии
+    const char* last_signal = "S05";
+
+    // Общее с сетевым потоком, под mutex
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::string> requests; // Тела пакетов без рамки; пустая строка - клиент отключился
+    std::string replies; // Готовые пакеты в рамке, ждут отправки
+    bool attach = false; // Подключился новый клиент
+    bool interrupt = false; // Пришёл Ctrl-C
+    bool stopping = false;
+    std::atomic<bool> pending{false}; // Есть хоть что-то из перечисленного выше
+
+    int listener = -1;
+    int wake[2] = {-1, -1}; // Будит сетевой поток: появились ответы или пора закрываться
+    std::thread server;
+
+    void serve();
+    void exchange(int client);
+    void reply(const std::string& payload);
+    void handle(const std::string& packet, Chip8& chip8);
+    void halt(const char* signal);
+    void detach();
+
+public:
+    GdbStub() = default;
+    GdbStub(const GdbStub&) = delete;
+    GdbStub& operator=(const GdbStub&) = delete;
+    ~GdbStub() { close(); }
+
+    // Слушает 127.0.0.1:port в своём потоке; клиенты по одному, после отключения ждём следующего
+    bool open(uint16_t port);
+    void close();
+
+    // Безопасная точка: выполняет накопившиеся запросы. Если цель остановлена - ждёт здесь до continue, step или detach.
+    void service(Chip8& chip8);
+    // Идёт кадрами с остановками по запросам отладчика. Останавливается после frames кадров или по k.
+    // interactive - для живой сессии: frames не смотрим, кадры идут с темпом 60 в секунду, конец - по k или D
+    // (обрыв связи без D не конец: ждём следующего клиента). Возвращает число законченных кадров.
+    uint64_t run(Chip8& chip8, uint64_t frames, bool interactive = false);
+    bool isKilled() const { return killed; }
+};
+
+#endif //GDBSTUB_H
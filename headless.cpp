@@ -0,0 +1,114 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "runner.h"
+
+// Прогон без окна и звука на полной скорости: для сборочных серверов и регрессий.
+// Печатает хэши кадра и состояния и скорость в виде key=value.
+int main(int argc, char *argv[]) {
+    RunConfig config;
+    const char *romdb_path = defaultRomDatabase();
+    const char *rng_name = "xorshift";
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+            config.frames = strtoull(argv[++i], nullptr, 10);
+            config.frames_set = true;
+        } else if (!strcmp(argv[i], "--quirks") && i + 1 < argc) {
+            config.quirks_name = argv[++i];
+            config.quirks_set = true;
+        } else if (!strcmp(argv[i], "--romdb") && i + 1 < argc)
+            romdb_path = argv[++i];
+        else if (!strcmp(argv[i], "--movie") && i + 1 < argc)
+            config.movie = argv[++i];
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            config.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        else if (!strcmp(argv[i], "--rng") && i + 1 < argc)
+            rng_name = argv[++i];
+        else if (!strcmp(argv[i], "--speed") && i + 1 < argc)
+            config.cycles_per_frame = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--profile") && i + 1 < argc)
+            config.profile = argv[++i];
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc)
+            config.trace = argv[++i];
+        else if (!strcmp(argv[i], "--break") && i + 1 < argc)
+            config.breakpoints.push_back(static_cast<uint16_t>(strtoul(argv[++i], nullptr, 16) & 0xFFF));
+        else if (!strcmp(argv[i], "--watch") && i + 1 < argc) {
+            // ADDR или ADDR-END включительно
+            char *end = nullptr;
+            const unsigned low = static_cast<unsigned>(strtoul(argv[++i], &end, 16)) & 0xFFF;
+            const unsigned high = *end == '-' ? static_cast<unsigned>(strtoul(end + 1, nullptr, 16)) & 0xFFF : low;
+            for (unsigned address = low; address <= high; ++address)
+                config.watchpoints.push_back(static_cast<uint16_t>(address));
+        } else if (!strcmp(argv[i], "--gdb") && i + 1 < argc)
+            config.gdb_port = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 10));
+        else if (argv[i][0] != '-' && config.rom.empty())
+            config.rom = argv[i];
+        else {
+            config.rom.clear();
+            break;
+        }
+    }
+
+    if (config.rom.empty() || !Quirks::fromName(config.quirks_name.c_str(), config.quirks)
+        || !rngModeFromName(rng_name, config.rng_mode)) {
+        fprintf(stderr, "Usage: chip8-headless <rom> [--frames N] [--quirks default|vip|schip|xochip] "
+                "[--movie FILE] [--seed N] [--rng xorshift|vip] [--speed CYCLES_PER_FRAME] [--profile PREFIX] [--trace FILE] "
+                "[--break ADDR]... [--watch ADDR[-END]]... [--gdb PORT] [--romdb FILE]\n"
+                "Breakpoints and watchpoints are hexadecimal; a run that hits one stops and exits with 3.\n"
+                "--gdb serves the GDB remote protocol on 127.0.0.1:PORT and waits for a debugger to attach;\n"
+                "without --frames it runs at 60 frames per second until the debugger kills or detaches.\n"
+                "--romdb (default $CHIP8_ROMDB) sets quirks and speed of known ROMs unless given explicitly.\n");
+        return 1;
+    }
+#ifndef CHIP8_PROFILER
+    if (!config.profile.empty()) {
+        fprintf(stderr, "--profile needs a build with -DCHIP8_PROFILER=ON\n");
+        return 1;
+    }
+#endif
+
+    RomDatabase romdb;
+    if (romdb_path) {
+        if (!romdb.open(romdb_path))
+            return 1;
+        config.romdb = &romdb;
+    }
+
+    if (config.gdb_port)
+        fprintf(stderr, "Waiting for gdb on 127.0.0.1:%u\n", config.gdb_port);
+    const RunResult result = runHeadless(config);
+    if (!result.loaded) {
+        fprintf(stderr, "Failed to load %s\n", config.movie.empty() ? config.rom.c_str() : config.movie.c_str());
+        return 1;
+    }
+
+    const double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+    printf("rom=%s\n", config.rom.c_str());
+    if (result.rom_record) {
+        const RomDbRecord &record = *result.rom_record;
+        printf("romdb_title=%.*s\n", static_cast<int>(sizeof(record.title)), record.title);
+        printf("platform=%s\n", platformName(static_cast<Platform>(record.platform)));
+    }
+    printf("quirks=%s\n", result.rom_record && !config.quirks_set ? "romdb" : config.quirks_name.c_str());
+    printf("frames=%" PRIu64 "\n", result.frames);
+    printf("cycles=%" PRIu64 "\n", result.cycles);
+    printf("framebuffer_hash=%016" PRIx64 "\n", result.framebuffer_hash);
+    printf("state_hash=%016" PRIx64 "\n", result.state_hash);
+    printf("fault=%s\n", faultName(result.fault));
+    printf("pc=0x%03X\n", result.pc);
+    if (result.stop != StopReason::None) {
+        printf("stop=%s\n", stopReasonName(result.stop));
+        printf("stop_address=0x%03X\n", result.stop_address);
+    }
+    if (!config.movie.empty())
+        printf("movie=%s\n", result.movie_match ? "match" : "mismatch");
+    printf("time_ms=%.3f\n", seconds * 1000);
+    printf("frames_per_second=%.0f\n", result.frames / seconds);
+    printf("instructions_per_second=%.0f\n", result.cycles / seconds);
+
+    if (!result.movie_match)
+        return 2;
+    return result.stop != StopReason::None ? 3 : 0;
+}
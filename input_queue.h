@@ -0,0 +1,59 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+#include <atomic>
+#include <cstdint>
+
+// Нажатие/отпускание клавиши, привязанное к циклу эмулятора
+struct InputEvent {
+    uint64_t cycle = 0; // Цикл, перед которым событие должно примениться
+    uint8_t key = 0; // 0x0-0xF
+    bool pressed = false;
+};
+
+// Lock-free очередь на одного писателя и одного читателя.
+// Писатель - поток ввода (или главный цикл), читатель - Chip8::runCycles.
+class InputQueue {
+    static constexpr uint32_t capacity = 256; // Степень двойки
+
+    InputEvent events[capacity];
+    std::atomic<uint32_t> head{0}; // Пишет только читатель
+    std::atomic<uint32_t> tail{0}; // Пишет только писатель
+
+public:
+    // Возвращает false, если очередь переполнена (событие теряется)
+    bool push(const InputEvent &event) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == capacity)
+            return false;
+
+        events[t & (capacity - 1)] = event;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Следующее событие или nullptr, если очередь пуста
+    const InputEvent *peek() const {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &events[h & (capacity - 1)];
+    }
+
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Позиция чтения: вернувшись к ней через rewind, события после неё прочитаются снова
+    uint32_t position() const { return head.load(std::memory_order_relaxed); }
+
+    // Только пока писатель молчит с момента position() (run-ahead: пишет тот же поток, что читает)
+    void rewind(const uint32_t position) { head.store(position, std::memory_order_release); }
+
+    // Только когда писатель гарантированно молчит (например, в initialize)
+    void clear() {
+        head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+};
+
+#endif //INPUT_QUEUE_H
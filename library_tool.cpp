@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "romlibrary.h"
+
+// Библиотека ROM: обход каталога с хэшированием и индекс на диске; поиск по индексу без обхода
+int main(int argc, char *argv[]) {
+    const char *directory = nullptr;
+    std::string index_path;
+    const char *find = nullptr;
+    unsigned threads = 0;
+    bool usage = false;
+    for (int i = 1; i < argc && !usage; ++i) {
+        if (!strcmp(argv[i], "--index") && i + 1 < argc)
+            index_path = argv[++i];
+        else if (!strcmp(argv[i], "--find") && i + 1 < argc)
+            find = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            threads = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+        else if (argv[i][0] != '-' && !directory)
+            directory = argv[i];
+        else
+            usage = true;
+    }
+    if (index_path.empty() && directory)
+        index_path = std::string(directory) + "/.chip8-library";
+
+    if (usage || index_path.empty() || (!directory && !find)) {
+        fprintf(stderr, "Usage: chip8-library <dir> [--index FILE] [--threads N]\n"
+                "       chip8-library --index FILE --find NAME|SHA1\n"
+                "Scans <dir> for .ch8/.xo8/.sc8, hashes new and changed files and updates the index\n"
+                "(default <dir>/.chip8-library). --find looks up the index without scanning.\n");
+        return 1;
+    }
+
+    RomLibrary library;
+    if (directory) {
+        FILE *existing = fopen(index_path.c_str(), "r");
+        if (existing) {
+            fclose(existing);
+            library.loadIndex(index_path.c_str()); // Битый индекс - просто хэшируем всё заново
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        ScanStats stats;
+        if (!library.scan(directory, threads, &stats))
+            return 1;
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (!library.saveIndex(index_path.c_str()))
+            return 1;
+        printf("directories=%zu roms=%zu hashed=%zu reused=%zu failed=%zu time_ms=%.1f index=%s\n", stats.directories,
+               stats.files, stats.hashed, stats.reused, stats.failed, elapsed.count() * 1000, index_path.c_str());
+    } else if (!library.loadIndex(index_path.c_str())) {
+        return 1;
+    }
+
+    if (find) {
+        uint8_t digest[sha1_size];
+        if (strlen(find) == sha1_size * 2 && parseSha1(find, digest)) {
+            const RomEntry *entry = library.findBySha1(digest);
+            if (!entry)
+                return 2;
+            printf("%s %" PRIu64 " %s\n", sha1Hex(entry->sha1).c_str(), entry->size, library.fullPath(*entry).c_str());
+            return 0;
+        }
+        const auto matches = library.findByName(find);
+        for (const RomEntry *entry : matches)
+            printf("%s %" PRIu64 " %s\n", sha1Hex(entry->sha1).c_str(), entry->size, library.fullPath(*entry).c_str());
+        return matches.empty() ? 2 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,423 @@
+#include "lockstep.h"
+
+#include <cstring>
+
+LockstepEngine::LockstepEngine(const size_t lanes)
+    : lanes(lanes), machines(new Chip8[lanes]), registers(16 * lanes), index(lanes), program_counter(lanes),
+      delay_timer(lanes), sound_timer(lanes), cycle_count(lanes), faulted(lanes), opcodes(lanes) {
+    for (size_t lane = 0; lane < lanes; ++lane)
+        machines[lane].initialize(static_cast<uint32_t>(lane));
+    gather();
+}
+
+void LockstepEngine::setQuirks(const Quirks &profile) {
+    quirks = profile;
+    for (size_t lane = 0; lane < lanes; ++lane)
+        machines[lane].setQuirks(profile);
+}
+
+void LockstepEngine::gatherLane(const size_t lane) {
+    const Chip8State &state = machines[lane].state;
+    for (unsigned r = 0; r < 16; ++r)
+        V(r)[lane] = state.V[r];
+    index[lane] = state.index;
+    program_counter[lane] = state.program_counter;
+    delay_timer[lane] = state.delay_timer;
+    sound_timer[lane] = state.sound_timer;
+    cycle_count[lane] = state.cycle_count;
+    opcodes[lane] = state.opcode;
+    faulted[lane] = state.fault != 0;
+}
+
+void LockstepEngine::scatterLane(const size_t lane) {
+    // Состояние упавшей полосы целиком в её Chip8, а полосы после падения мусорные
+    if (faulted[lane])
+        return;
+
+    Chip8State &state = machines[lane].state;
+    for (unsigned r = 0; r < 16; ++r)
+        state.V[r] = V(r)[lane];
+    state.index = index[lane];
+    state.program_counter = program_counter[lane];
+    state.delay_timer = delay_timer[lane];
+    state.sound_timer = sound_timer[lane];
+    state.cycle_count = cycle_count[lane];
+    state.opcode = opcodes[lane];
+}
+
+void LockstepEngine::setKey(const size_t lane, const uint8_t key, const bool pressed) {
+    machines[lane].state.key[key & 0xF] = pressed;
+}
+
+void LockstepEngine::gather() {
+    fault_count = 0;
+    code_shared = true;
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        gatherLane(lane);
+        fault_count += faulted[lane];
+        if (code_shared && lane > 0)
+            code_shared = memcmp(machines[lane].state.memory, machines[0].state.memory, sizeof(Chip8State::memory)) == 0;
+    }
+}
+
+void LockstepEngine::gatherReloaded(const size_t lane) {
+    fault_count -= faulted[lane];
+    gatherLane(lane);
+    fault_count += faulted[lane];
+
+    // Остальные полосы между собой совпадают, так что хватит сравнить с любой из них
+    if (code_shared && lanes > 1) {
+        const Chip8 &chip8 = machines[lane];
+        const Chip8 &other = machines[lane == 0 ? 1 : 0];
+        // Обе сброшены от одного снимка: отличаться могут только страницы, изменённые после сброса
+        uint64_t pages = ~0ULL;
+        if (chip8.reset_source && chip8.reset_source == other.reset_source)
+            pages = chip8.reset_memory | chip8.dirty_memory | other.reset_memory | other.dirty_memory;
+
+        while (pages && code_shared) {
+            const size_t offset = __builtin_ctzll(pages) * dirty_page_size;
+            pages &= pages - 1;
+            code_shared = memcmp(chip8.state.memory + offset, other.state.memory + offset, dirty_page_size) == 0;
+        }
+    }
+}
+
+void LockstepEngine::scatter() {
+    for (size_t lane = 0; lane < lanes; ++lane)
+        scatterLane(lane);
+}
+
+void LockstepEngine::executeLane(const size_t lane) {
+    scatterLane(lane);
+    Chip8 &chip8 = machines[lane];
+    const uint16_t address = chip8.state.index;
+    chip8.emulateCycle();
+    ++chip8.state.cycle_count;
+    gatherLane(lane);
+
+    if (faulted[lane])
+        ++fault_count;
+
+    // FX33/FX55 пишут в память. Сравнивать с другими полосами рано - они эту запись ещё не сделали,
+    // поэтому только запоминаем страницы, а сравниваем в checkWrittenPages после всех полос.
+    const uint16_t opcode = chip8.state.opcode;
+    if (code_shared && ((opcode & 0xF0FF) == 0xF033 || (opcode & 0xF0FF) == 0xF055)) {
+        const uint16_t length = (opcode & 0xF0FF) == 0xF033 ? 3 : ((opcode & 0x0F00) >> 8) + 1;
+        written_pages |= 1ULL << ((address & 0xFFF) / dirty_page_size);
+        written_pages |= 1ULL << (((address + length - 1) & 0xFFF) / dirty_page_size);
+    }
+}
+
+void LockstepEngine::checkWrittenPages() {
+    // До шага память полос совпадала, так что отличаться могут только записанные страницы
+    uint64_t pages = written_pages;
+    written_pages = 0;
+    while (pages && code_shared) {
+        const size_t offset = __builtin_ctzll(pages) * dirty_page_size;
+        pages &= pages - 1;
+        for (size_t lane = 1; lane < lanes && code_shared; ++lane)
+            code_shared = memcmp(machines[lane].state.memory + offset, machines[0].state.memory + offset,
+                                 dirty_page_size) == 0;
+    }
+}
+
+bool LockstepEngine::execute(const uint16_t opcode, const size_t begin, const size_t end) {
+    const unsigned x = (opcode & 0x0F00) >> 8;
+    const unsigned y = (opcode & 0x00F0) >> 4;
+    const uint8_t nn = opcode & 0x00FF;
+    const uint16_t nnn = opcode & 0x0FFF;
+    uint8_t *vx = V(x);
+    const uint8_t *vy = V(y);
+    uint8_t *vf = V(0xF);
+    uint16_t *pc = program_counter.data();
+
+    // Каждая ветка - простой цикл по полосам без зависимостей между ними, это и векторизуется.
+    // Порядок записи VF и VX повторяет Chip8::emulateCycle один в один.
+    // Стек, экран, клавиши и ГСЧ берутся прямо из Chip8 полосы, без полной синхронизации регистров.
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            if (opcode == 0x00E0) {
+                for (size_t l = begin; l < end; ++l) {
+                    Chip8 &chip8 = machines[l];
+                    memset(chip8.state.gfx, 0, sizeof(chip8.state.gfx));
+                    chip8.dirty_gfx = ~0U;
+                }
+                break;
+            }
+            if (opcode == 0x00EE) {
+                // Ошибку стека (Fault) ставит только Chip8::emulateCycle
+                for (size_t l = begin; l < end; ++l)
+                    if (machines[l].state.stack_pointer == 0)
+                        return false;
+                for (size_t l = begin; l < end; ++l) {
+                    Chip8State &state = machines[l].state;
+                    pc[l] = state.stack[state.stack_pointer] + 2;
+                    state.stack_pointer--;
+                }
+                return true;
+            }
+            return false;
+
+        case 0x1000:
+            for (size_t l = begin; l < end; ++l)
+                pc[l] = nnn;
+            return true;
+
+        case 0x2000:
+            for (size_t l = begin; l < end; ++l)
+                if (machines[l].state.stack_pointer >= 15)
+                    return false;
+            for (size_t l = begin; l < end; ++l) {
+                Chip8State &state = machines[l].state;
+                state.stack_pointer++;
+                state.stack[state.stack_pointer] = pc[l];
+                pc[l] = nnn;
+            }
+            return true;
+
+        case 0x3000:
+            for (size_t l = begin; l < end; ++l)
+                pc[l] += vx[l] == nn ? 4 : 2;
+            return true;
+
+        case 0x4000:
+            for (size_t l = begin; l < end; ++l)
+                pc[l] += vx[l] != nn ? 4 : 2;
+            return true;
+
+        case 0x5000:
+            if ((opcode & 0x000F) != 0)
+                return false;
+            for (size_t l = begin; l < end; ++l)
+                pc[l] += vx[l] == vy[l] ? 4 : 2;
+            return true;
+
+        case 0x6000:
+            for (size_t l = begin; l < end; ++l)
+                vx[l] = nn;
+            break;
+
+        case 0x7000:
+            for (size_t l = begin; l < end; ++l)
+                vx[l] += nn;
+            break;
+
+        case 0x8000:
+            switch (opcode & 0x000F) {
+                case 0x0:
+                    for (size_t l = begin; l < end; ++l)
+                        vx[l] = vy[l];
+                    break;
+                case 0x1:
+                    for (size_t l = begin; l < end; ++l)
+                        vx[l] |= vy[l];
+                    break;
+                case 0x2:
+                    for (size_t l = begin; l < end; ++l)
+                        vx[l] &= vy[l];
+                    break;
+                case 0x3:
+                    for (size_t l = begin; l < end; ++l)
+                        vx[l] ^= vy[l];
+                    break;
+                case 0x4:
+                    for (size_t l = begin; l < end; ++l) {
+                        const unsigned sum = vx[l] + vy[l];
+                        vx[l] = sum & 0xFF;
+                        vf[l] = sum > 255;
+                    }
+                    break;
+                case 0x5:
+                    for (size_t l = begin; l < end; ++l) {
+                        const uint8_t flag = vx[l] >= vy[l];
+                        vx[l] = vx[l] - vy[l];
+                        vf[l] = flag;
+                    }
+                    break;
+                case 0x6:
+                    for (size_t l = begin; l < end; ++l) {
+                        const uint8_t source = quirks.shift_uses_vy ? vy[l] : vx[l];
+                        vx[l] = source >> 1;
+                        vf[l] = source & 0x1;
+                    }
+                    break;
+                case 0x7:
+                    for (size_t l = begin; l < end; ++l) {
+                        const uint8_t flag = vy[l] >= vx[l];
+                        vx[l] = vy[l] - vx[l];
+                        vf[l] = flag;
+                    }
+                    break;
+                case 0xE:
+                    for (size_t l = begin; l < end; ++l) {
+                        const uint8_t source = quirks.shift_uses_vy ? vy[l] : vx[l];
+                        vx[l] = source << 1;
+                        vf[l] = source >> 7;
+                    }
+                    break;
+                default:
+                    return false;
+            }
+            if (quirks.logic_resets_vf && (opcode & 0x000F) >= 0x1 && (opcode & 0x000F) <= 0x3) {
+                for (size_t l = begin; l < end; ++l)
+                    vf[l] = 0;
+            }
+            break;
+
+        case 0x9000:
+            if ((opcode & 0x000F) != 0)
+                return false;
+            for (size_t l = begin; l < end; ++l)
+                pc[l] += vx[l] != vy[l] ? 4 : 2;
+            return true;
+
+        case 0xA000:
+            for (size_t l = begin; l < end; ++l)
+                index[l] = nnn;
+            break;
+
+        case 0xC000:
+            for (size_t l = begin; l < end; ++l) {
+                Chip8 &chip8 = machines[l];
+                chip8.state.cycle_count = cycle_count[l]; // Его читает ГСЧ в режиме Vip
+                vx[l] = chip8.nextRandom() & nn;
+            }
+            break;
+
+        case 0xD000:
+            for (size_t l = begin; l < end; ++l) {
+                Chip8 &chip8 = machines[l];
+                chip8.state.index = index[l];
+                const uint8_t collision = chip8.drawSprite(vx[l], vy[l], opcode & 0x000F);
+                vf[l] = collision;
+            }
+            break;
+
+        case 0xE000:
+            if (nn != 0x9E && nn != 0xA1)
+                return false;
+            for (size_t l = begin; l < end; ++l) {
+                const bool pressed = machines[l].state.key[vx[l] & 0xF] != 0;
+                pc[l] += pressed == (nn == 0x9E) ? 4 : 2;
+            }
+            return true;
+
+        case 0xF000:
+            switch (nn) {
+                case 0x07:
+                    for (size_t l = begin; l < end; ++l)
+                        vx[l] = delay_timer[l];
+                    break;
+                case 0x15:
+                    for (size_t l = begin; l < end; ++l)
+                        delay_timer[l] = vx[l];
+                    break;
+                case 0x18:
+                    for (size_t l = begin; l < end; ++l)
+                        sound_timer[l] = vx[l];
+                    break;
+                case 0x1E:
+                    for (size_t l = begin; l < end; ++l)
+                        index[l] += vx[l];
+                    break;
+                case 0x29:
+                    for (size_t l = begin; l < end; ++l)
+                        index[l] = vx[l] * 5;
+                    break;
+                default:
+                    return false;
+            }
+            break;
+
+        default:
+            // Стек, клавиши и память - полной синхронизацией полосы через Chip8::emulateCycle
+            return false;
+    }
+
+    for (size_t l = begin; l < end; ++l)
+        pc[l] += 2;
+    return true;
+}
+
+bool LockstepEngine::fetch() {
+    // Частый случай: один ROM во всех полосах и все на одном PC - читаем код один раз.
+    // Проверка PC - один проход по массиву, без похода в память каждой полосы.
+    if (code_shared && !fault_count) {
+        const uint16_t pc0 = program_counter[0];
+        bool same_pc = true;
+        for (size_t l = 0; l < lanes; ++l)
+            same_pc &= program_counter[l] == pc0;
+
+        if (same_pc) {
+            const uint8_t *memory = machines[0].state.memory;
+            const uint16_t opcode = memory[pc0 & 0xFFF] << 8 | memory[(pc0 + 1) & 0xFFF];
+            for (size_t l = 0; l < lanes; ++l)
+                opcodes[l] = opcode;
+            return true;
+        }
+    }
+
+    size_t first = lanes;
+    bool uniform = true;
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        if (faulted[lane])
+            continue;
+
+        const uint8_t *memory = machines[lane].state.memory;
+        const uint16_t pc = program_counter[lane] & 0xFFF;
+        opcodes[lane] = memory[pc] << 8 | memory[(pc + 1) & 0xFFF];
+        if (first == lanes)
+            first = lane;
+        else if (opcodes[lane] != opcodes[first])
+            uniform = false;
+    }
+    return uniform;
+}
+
+void LockstepEngine::runCycles(const uint32_t count) {
+    for (uint32_t step = 0; step < count && fault_count < lanes; ++step) {
+        const bool uniform = fetch();
+
+        size_t first = 0;
+        while (faulted[first])
+            ++first;
+
+        // Векторные ветки трогают и упавшие полосы, но там мусор никому не нужен.
+        // Ветки, лезущие в Chip8 полосы (стек, экран, клавиши, ГСЧ), по упавшим идти не должны.
+        const uint16_t opcode = opcodes[first];
+        const bool per_lane = (opcode & 0xF000) == 0x0000 || (opcode & 0xF000) == 0x2000
+                              || (opcode & 0xF000) == 0xC000 || (opcode & 0xF000) == 0xD000 || (opcode & 0xF000) == 0xE000;
+        if (uniform && !(per_lane && fault_count) && execute(opcode, 0, lanes)) {
+            ++uniform_steps;
+            for (size_t l = 0; l < lanes; ++l)
+                ++cycle_count[l];
+            continue;
+        }
+
+        // Разошлись: та же таблица, но по одной полосе
+        ++divergent_steps;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            if (faulted[lane])
+                continue;
+            if (execute(opcodes[lane], lane, lane + 1))
+                ++cycle_count[lane];
+            else
+                executeLane(lane);
+        }
+        if (written_pages)
+            checkWrittenPages();
+    }
+}
+
+void LockstepEngine::runFrame() {
+    runCycles(cycles_per_frame);
+    for (size_t l = 0; l < lanes; ++l) {
+        delay_timer[l] -= delay_timer[l] > 0;
+        sound_timer[l] -= sound_timer[l] > 0;
+    }
+    // Таймеры упавших полос, как и у Chip8, продолжают идти - но уже в самом Chip8
+    if (fault_count)
+        for (size_t l = 0; l < lanes; ++l)
+            if (faulted[l])
+                machines[l].tickTimers();
+}
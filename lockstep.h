@@ -0,0 +1,73 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "chip8.h"
+
+// Много экземпляров в ногу (для RL: тысячи сред на ядро).
+// V, I, PC и таймеры лежат полосами по экземплярам (structure of arrays). Если у всех живых полос
+// одна и та же инструкция, она выполняется одним циклом по полосам, который компилятор
+// разворачивает в SSE/AVX2/AVX-512. Разошедшиеся полосы идут по одной через ту же таблицу,
+// а стек, клавиши и память - через обычный Chip8::emulateCycle с синхронизацией регистров.
+// Память, стек, экран и клавиши остаются в Chip8 каждой полосы.
+class LockstepEngine {
+    size_t lanes;
+    std::unique_ptr<Chip8[]> machines;
+    std::vector<uint8_t> registers; // V[r] полосы l - registers[r * lanes + l]
+    std::vector<uint16_t> index;
+    std::vector<uint16_t> program_counter;
+    std::vector<uint8_t> delay_timer;
+    std::vector<uint8_t> sound_timer;
+    std::vector<uint64_t> cycle_count;
+    std::vector<uint8_t> faulted; // Упавшие полосы стоят, их состояние живёт в Chip8
+    std::vector<uint16_t> opcodes; // Последняя выбранная инструкция каждой полосы
+    size_t fault_count = 0;
+    bool code_shared = false; // Память всех полос одинакова (один ROM, одинаковые записи)
+    uint64_t written_pages = 0; // Страницы памяти, записанные полосами за текущий шаг (FX33, FX55)
+    Quirks quirks;
+    uint32_t cycles_per_frame = 10;
+    uint64_t uniform_steps = 0;
+    uint64_t divergent_steps = 0;
+
+    uint8_t *V(const unsigned r) { return &registers[r * lanes]; }
+    bool fetch(); // Заполняет opcodes; true - у всех живых полос одна инструкция
+    // Выполняет opcode на полосах [begin, end); false - инструкция только через executeLane
+    bool execute(uint16_t opcode, size_t begin, size_t end);
+    void executeLane(size_t lane);
+    // После шага по полосам: общий код остался общим, если записанные страницы у всех полос совпали
+    void checkWrittenPages();
+
+public:
+    explicit LockstepEngine(size_t lanes);
+
+    size_t size() const { return lanes; }
+    // Для настройки полосы (initialize, loadROM, клавиши). После правок регистров - gather().
+    Chip8 &machine(size_t lane) { return machines[lane]; }
+    const Chip8 &machine(size_t lane) const { return machines[lane]; }
+
+    // Полосы обязаны разделять причуды и скорость: иначе одна инструкция значит разное
+    void setQuirks(const Quirks &profile);
+    void setCyclesPerFrame(uint32_t cycles) { cycles_per_frame = cycles ? cycles : 1; }
+
+    // Клавиши читаются только по полосам, поэтому живут в Chip8; очередь ввода здесь не используется
+    void setKey(size_t lane, uint8_t key, bool pressed);
+
+    void gather(); // Регистры из Chip8 в полосы
+    void scatter(); // Обратно, чтобы читать состояние через machine()
+    void gatherLane(size_t lane);
+    void scatterLane(size_t lane);
+    // Как gatherLane, но после того, как у полосы сменилась память (сброс, новый ROM)
+    void gatherReloaded(size_t lane);
+
+    void runCycles(uint32_t count);
+    void runFrame();
+
+    // Сколько шагов прошло в ногу и сколько по полосам - насколько хорошо ROM векторизуется
+    uint64_t getUniformSteps() const { return uniform_steps; }
+    uint64_t getDivergentSteps() const { return divergent_steps; }
+};
+
+#endif //LOCKSTEP_H
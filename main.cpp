@@ -1,36 +1,355 @@
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+
 #include "chip8.h"
+#include "framestats.h"
+#include "frontend.h"
+#include "mapped_file.h"
+#include "movie.h"
+#include "rewind.h"
+#include "romdb.h"
+#include "runahead.h"
+#include "runner.h"
+#include "savestate.h"
 #include "lib/tinyfiledialogs/tinyfiledialogs.h"
 
-Chip8 emulator;
+// ROM в машину, его SHA-1 - в rom_sha1 (для роликов). Если ROM есть в базе настроек - его quirks, скорость,
+// а с frontend ещё цвета и клавиши.
+static bool loadRom(Chip8 &emulator, const char *file, const RomDatabase &romdb, Frontend *frontend,
+                    uint8_t rom_sha1[sha1_size]) {
+    MappedFile rom;
+    if (!rom.open(file)) {
+        std::cout << "Failed to open file " << file << std::endl;
+        return false;
+    }
+    if (!emulator.loadROM(rom.data(), rom.size()))
+        return false;
+
+    sha1(rom.data(), rom.size(), rom_sha1);
+    const RomDbRecord *record = romdb.find(rom_sha1);
+    if (!record)
+        return true;
+    emulator.setQuirks(unpackQuirks(record->quirks));
+    if (record->cycles_per_frame)
+        emulator.setCyclesPerFrame(record->cycles_per_frame);
+    if (frontend) {
+        if (record->palette[0] || record->palette[1])
+            frontend->setPalette(record->palette[0], record->palette[1]);
+        frontend->setKeys(record->keys);
+    }
+    const Platform platform = static_cast<Platform>(record->platform);
+    const std::string title(record->title, strnlen(record->title, sizeof(record->title)));
+    std::cout << "ROM database: " << (title.empty() ? "untitled" : title) << " (" << platformName(platform) << ")"
+            << std::endl;
+    if (platform != Platform::Chip8)
+        std::cout << "Only CHIP-8 instructions are supported, " << platformName(platform)
+                << " extensions will stop the machine" << std::endl;
+    return true;
+}
 
 // Источники инфы:
 // - https://multigesture.net/articles/how-to-write-an-emulator-chip-8-interpreter/
 // - https://en.wikipedia.org/wiki/CHIP-8
 // - ChatGPT :)
-int main() {
-    emulator.initialize();
-    emulator.setupGraphics();
+int main(int argc, char *argv[]) {
+    const auto launch = std::chrono::steady_clock::now();
+    Chip8 emulator;
+    const char *file = nullptr;
+    const char *record_path = nullptr;
+    const char *replay_path = nullptr;
+    const char *stats_path = nullptr;
+    uint32_t run_ahead_frames = 0;
+    const char *romdb_path = defaultRomDatabase();
+    const char *quirks_name = nullptr; // Явный --quirks перекрывает базу настроек, как и --speed
+    const char *rng_name = "xorshift";
+    uint32_t speed = 0;
+    int scale = 10;
+    bool audio = true;
+    bool headless = false;
+    bool bench = false;
+    uint64_t frame_limit = 0; // --frames; 0 - без ограничения
+    bool usage = false;
+    for (int i = 1; i < argc && !usage; ++i) {
+        if (!strcmp(argv[i], "--record") && i + 1 < argc)
+            record_path = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && i + 1 < argc)
+            replay_path = argv[++i];
+        else if (!strcmp(argv[i], "--frame-stats") && i + 1 < argc)
+            stats_path = argv[++i];
+        else if (!strcmp(argv[i], "--run-ahead") && i + 1 < argc)
+            run_ahead_frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--romdb") && i + 1 < argc)
+            romdb_path = argv[++i];
+        else if (!strcmp(argv[i], "--quirks") && i + 1 < argc)
+            quirks_name = argv[++i];
+        else if (!strcmp(argv[i], "--rng") && i + 1 < argc)
+            rng_name = argv[++i];
+        else if (!strcmp(argv[i], "--speed") && i + 1 < argc)
+            speed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--scale") && i + 1 < argc)
+            scale = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+            frame_limit = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--no-audio"))
+            audio = false;
+        else if (!strcmp(argv[i], "--headless"))
+            headless = true;
+        else if (!strcmp(argv[i], "--bench"))
+            bench = true;
+        else if (argv[i][0] != '-' && !file)
+            file = argv[i];
+        else
+            usage = true;
+    }
 
-    const char *filters[] = {"*.ch8"};
-    const char *file = tinyfd_openFileDialog("Выбрать ROM", "", 1, filters, "CHIP‑8 ROM", 0);
-    if (file) {
-        emulator.loadROM(file);
+    Quirks quirks;
+    if (quirks_name && !Quirks::fromName(quirks_name, quirks))
+        usage = true;
+    RngMode rng_mode = RngMode::Xorshift;
+    if (!rngModeFromName(rng_name, rng_mode))
+        usage = true;
+    // Без окна и замеры - только с ROM из командной строки: диалог им не нужен
+    if (usage || scale < 1 || scale > 64 || ((headless || bench || replay_path) && !file)) {
+        fprintf(stderr, "Usage: chip8 [rom] [--scale N] [--speed CYCLES_PER_FRAME] [--quirks default|vip|schip|xochip]\n"
+                "             [--rng xorshift|vip] [--no-audio] [--romdb FILE] [--record MOVIE] [--run-ahead N]\n"
+                "             [--frame-stats FILE]\n"
+                "       chip8 <rom> --headless [--frames N] [--speed N] [--quirks NAME] [--rng NAME]\n"
+                "       chip8 <rom> --bench [--frames N] ...\n"
+                "       chip8 <rom> --replay MOVIE\n"
+                "Without a ROM a file dialog asks for one. --headless runs without a window and prints hashes;\n"
+                "--bench runs the window without the 60 fps limit for N frames (default 600) and prints timings.\n");
+        return 1;
     }
 
+    // Без базы - пустая: ROM просто не находится
+    RomDatabase romdb;
+    if (romdb_path && !romdb.open(romdb_path))
+        return 1;
+
+    if (headless) {
+        // То же, что chip8-headless: без SDL, без окна и на полной скорости
+        RunConfig config;
+        config.rom = file;
+        config.frames = frame_limit ? frame_limit : config.frames;
+        config.frames_set = true;
+        config.quirks = quirks;
+        config.quirks_set = quirks_name != nullptr;
+        config.rng_mode = rng_mode;
+        config.cycles_per_frame = speed;
+        config.romdb = &romdb;
+        const RunResult result = runHeadless(config);
+        if (!result.loaded)
+            return 1;
+        printf("frames=%" PRIu64 "\ncycles=%" PRIu64 "\nframebuffer_hash=%016" PRIx64 "\nfault=%s\ntime_ms=%.3f\n",
+               result.frames, result.cycles, result.framebuffer_hash, faultName(result.fault), result.seconds * 1000);
+        return 0;
+    }
+
+    if (replay_path) {
+        // Воспроизведение без окна и без ограничения скорости
+        Movie movie;
+        if (!movie.load(replay_path)) {
+            std::cout << "Failed to load movie " << replay_path << std::endl;
+            return 1;
+        }
+
+        emulator.initialize(movie.seed);
+        uint8_t rom_sha1[sha1_size];
+        if (!loadRom(emulator, file, romdb, nullptr, rom_sha1))
+            return 1;
+        if (quirks_name)
+            emulator.setQuirks(quirks); // Только для роликов версии 1: новые хранят свои quirks
+        const bool match = playMovie(emulator, movie, rom_sha1);
+        if (emulator.getFault() != Fault::None)
+            std::cout << "Fault " << faultName(emulator.getFault()) << ": opcode " << std::hex
+                    << emulator.getState().opcode << " at " << emulator.getState().program_counter << std::dec
+                    << ", replay stopped" << std::endl;
+        std::cout << "Replayed " << movie.frame_count << " frames: "
+                << (match ? "framebuffer matches" : "framebuffer MISMATCH") << std::endl;
+        return match ? 0 : 2;
+    }
+
+    // Диалог - только когда ROM не дали: он запускает внешние процессы и может идти сотни миллисекунд
+    if (!file) {
+        const char *filters[] = {"*.ch8"};
+        file = tinyfd_openFileDialog("Выбрать ROM", "", 1, filters, "CHIP‑8 ROM", 0);
+        if (!file)
+            return 1;
+    }
+
+    emulator.initialize(static_cast<uint32_t>(time(nullptr)));
+    emulator.setRngMode(rng_mode);
+    Frontend frontend;
+    frontend.setupGraphics(scale, audio);
+    Movie movie;
+    if (!loadRom(emulator, file, romdb, &frontend, movie.rom_sha1))
+        return 1;
+    if (quirks_name)
+        emulator.setQuirks(quirks);
+    if (speed)
+        emulator.setCyclesPerFrame(speed);
+    if (bench && !frame_limit)
+        frame_limit = 600;
+
+    if (record_path)
+        emulator.setInputRecorder(&movie.events);
+    uint64_t frames = 0;
+
+    // Backspace зажат - крутим назад. При записи ролика выключено: запись разошлась бы с игрой.
+    RewindBuffer rewind;
+    bool rewinding = false;
+    bool rewind_started = false; // Первый кадр перемотки: свежий снимок в буфере - это текущее состояние
+    // F5 - снимок в <rom>.state, F9 - загрузка. При записи ролика загрузка выключена, как и перемотка.
+    const std::string state_path = std::string(file) + ".state";
+
+    RunAhead run_ahead(run_ahead_frames);
+    bool run_ahead_warned = false;
+    bool fault_reported = false;
+
+    // Гистограммы и история для оверлея идут всегда, они дешёвые. Записи по кадрам копятся только для
+    // --frame-stats: CSV и сводка - при выходе.
+    FrameStats stats(stats_path != nullptr);
+
+    const uint32_t cycles_per_frame = emulator.getCyclesPerFrame();
+    Uint32 frame_start = SDL_GetTicks();
+    uint64_t next_event_cycle = 0;
+    double startup_ms = 0; // От запуска до первого показанного кадра
+
+    // Выход: закрыли окно или --frames кадров прошло
+    const auto finish = [&]() {
+        if (record_path) {
+            movie.seed = emulator.getSeed();
+            movie.rng_mode = emulator.getRngMode();
+            movie.quirks = packQuirks(emulator.getQuirks());
+            movie.cycles_per_frame = cycles_per_frame;
+            movie.frame_count = frames;
+            movie.framebuffer_hash = emulator.framebufferHash();
+            if (!movie.save(record_path))
+                std::cout << "Failed to save movie " << record_path << std::endl;
+        }
+        if (stats_path) {
+            stats.writeCsv(stats_path);
+            stats.printSummary(stdout);
+        }
+        if (bench) {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - launch;
+            printf("startup_ms=%.3f\nframes=%" PRIu64 "\ntime_ms=%.3f\nframes_per_second=%.0f\n", startup_ms, frames,
+                   elapsed.count() * 1000, frames / (elapsed.count() > 0 ? elapsed.count() : 1e-9));
+        }
+        return 0;
+    };
+
     while (true) {
-        emulator.emulateCycle();
-        emulator.renderGraphics();
+        // События, собранные сейчас, произошли во время предыдущего кадра.
+        // Переносим их на тот же относительный цикл внутри следующей пачки инструкций.
+        const uint64_t batch_start = emulator.getCycleCount();
+        stats.mark(FrameStage::Poll);
 
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                SDL_Quit();
-                return 0;
+            if (event.type == SDL_QUIT)
+                return finish();
+
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F1) {
+                if (!event.key.repeat)
+                    frontend.toggleOverlay();
+                continue;
             }
 
-            if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
-                emulator.handleKeyEvent(event);
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F5) {
+                if (!event.key.repeat) {
+                    const bool saved = saveStateFile(emulator, state_path.c_str());
+                    std::cout << (saved ? "Saved state to " : "Failed to save state to ") << state_path << std::endl;
+                }
+                continue;
             }
+
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F9) {
+                if (!event.key.repeat && !record_path) {
+                    if (loadStateFile(emulator, state_path.c_str()))
+                        next_event_cycle = 0; // Счётчик циклов ушёл вместе с состоянием
+                    else
+                        std::cout << "Failed to load state from " << state_path << std::endl;
+                }
+                continue;
+            }
+
+            if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && event.key.keysym.sym == SDLK_BACKSPACE) {
+                const bool was_rewinding = rewinding;
+                rewinding = event.type == SDL_KEYDOWN && !record_path;
+                rewind_started = rewind_started || (rewinding && !was_rewinding);
+                continue;
+            }
+
+            if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && !event.key.repeat) {
+                const Uint32 offset_ms = event.key.timestamp > frame_start ? event.key.timestamp - frame_start : 0;
+                uint64_t cycle = batch_start + offset_ms * cycles_per_frame * 60 / 1000;
+                if (cycle >= batch_start + cycles_per_frame)
+                    cycle = batch_start + cycles_per_frame - 1;
+                // Два события на одном цикле схлопнулись бы (нажал и отпустил - ничего не было)
+                if (cycle < next_event_cycle)
+                    cycle = next_event_cycle;
+                next_event_cycle = cycle + 1;
+
+                const Uint32 now = SDL_GetTicks();
+                stats.input(now > event.key.timestamp ? now - event.key.timestamp : 0);
+                frontend.handleKeyEvent(emulator, event, cycle);
+            }
+        }
+
+        frame_start = SDL_GetTicks();
+        stats.mark(FrameStage::EmulateStart);
+        if (rewinding) {
+            Chip8State previous;
+            if (rewind_started) {
+                rewind.pop(previous); // Снят после последнего кадра, то есть совпадает с тем, что на экране
+                rewind_started = false;
+            }
+            if (rewind.pop(previous))
+                emulator.setState(previous);
+            next_event_cycle = 0; // Счётчик циклов ушёл назад вместе с состоянием
+        } else {
+            emulator.runFrame();
+            ++frames;
+            if (emulator.getFault() != Fault::None && !fault_reported) {
+                const Chip8State &state = emulator.getState();
+                std::cout << "Fault " << faultName(emulator.getFault()) << ": opcode " << std::hex << state.opcode
+                        << " at " << state.program_counter << std::dec << std::endl;
+                fault_reported = true;
+            }
+            rewind.push(emulator.getState(), emulator.getDirtyMemoryPages(), emulator.getDirtyGfxPages());
+            emulator.clearDirtyPages();
         }
+        stats.mark(FrameStage::EmulateEnd);
+
+        // Во время перемотки не забегаем вперёд: упреждающие кадры съели бы ввод из очереди
+        if (!rewinding)
+            run_ahead.speculate(emulator);
+        frontend.renderGraphics(emulator, &stats);
+        if (!rewinding)
+            run_ahead.restore(emulator);
+        frontend.updateSound(emulator);
+        if (stats.getFrames() == 1)
+            startup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - launch).count();
+
+        if (!run_ahead.keepingUp() && !run_ahead_warned) {
+            std::cout << "Run-ahead " << run_ahead.getFrames() << ": emulation takes " << run_ahead.getFrameCostMs()
+                    << " ms per frame, too slow to keep up at 60 fps" << std::endl;
+            run_ahead_warned = true;
+        }
+
+        if (frame_limit && frames >= frame_limit)
+            return finish();
+
+        // --bench меряет, сколько кадров успевает фронтенд, без ограничения 60 кадрами
+        const Uint32 elapsed = SDL_GetTicks() - frame_start;
+        if (!bench && elapsed < 1000 / 60)
+            SDL_Delay(1000 / 60 - elapsed);
     }
 }
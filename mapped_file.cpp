@@ -0,0 +1,63 @@
+#include "mapped_file.h"
+
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const char *filename) {
+    close();
+#ifdef _WIN32
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        buffer.insert(buffer.end(), chunk, chunk + got);
+    fclose(file);
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+#else
+    const int fd = ::open(filename, O_RDONLY);
+    struct stat info{};
+    if (fd < 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        if (fd >= 0)
+            ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    if (!length) { // mmap нулевой длины не бывает
+        ::close(fd);
+        bytes = buffer.data();
+        return true;
+    }
+    void *memory = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // Отображение держит файл и без дескриптора
+    if (memory == MAP_FAILED) {
+        length = 0;
+        return false;
+    }
+    bytes = static_cast<const uint8_t *>(memory);
+    mapped = true;
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped)
+        munmap(const_cast<uint8_t *>(bytes), length);
+#endif
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
@@ -0,0 +1,29 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Файл целиком, только для чтения: mmap, без промежуточного буфера и лишнего копирования.
+// Где mmap нет (Windows), читается в память обычным fread.
+class MappedFile {
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<uint8_t> buffer; // Без mmap и для пустых файлов
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    // Молча: о неудаче сообщает вызывающий (chip8-batch - строкой результата, не вперемешку с ней)
+    bool open(const char* filename);
+    void close();
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+#endif //MAPPED_FILE_H
@@ -0,0 +1,170 @@
+#include "movie.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "chip8.h"
+
+namespace {
+    const char movie_magic[4] = {'C', '8', 'M', 'V'};
+    constexpr uint16_t movie_version = 2; // 2: quirks и SHA-1 ROM после числа событий
+
+    void putLE(std::vector<uint8_t> &out, uint64_t value, const int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            out.push_back(value & 0xFF);
+            value >>= 8;
+        }
+    }
+
+    uint64_t getLE(const uint8_t *&in, const int bytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+            value |= static_cast<uint64_t>(*in++) << (8 * i);
+        return value;
+    }
+
+    void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(value);
+    }
+
+    bool getVarint(const uint8_t *&in, const uint8_t *end, uint64_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && in < end; shift += 7) {
+            const uint8_t byte = *in++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+}
+
+bool Movie::save(const char *filename) const {
+    std::vector<uint8_t> data(movie_magic, movie_magic + 4);
+    putLE(data, movie_version, 2);
+    putLE(data, static_cast<uint8_t>(rng_mode), 2);
+    putLE(data, seed, 4);
+    putLE(data, cycles_per_frame, 4);
+    putLE(data, frame_count, 8);
+    putLE(data, framebuffer_hash, 8);
+    putLE(data, events.size(), 4);
+    putLE(data, quirks, 2);
+    data.insert(data.end(), rom_sha1, rom_sha1 + sha1_size);
+
+    // Обычно между нажатиями сотни-тысячи циклов, так что событие занимает 2-3 байта
+    uint64_t previous = 0;
+    for (const InputEvent &event: events) {
+        putVarint(data, event.cycle - previous);
+        data.push_back(event.key | (event.pressed ? 0x80 : 0x00));
+        previous = event.cycle;
+    }
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    const bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && ok;
+}
+
+bool Movie::load(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        return false;
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t bytesRead;
+    while ((bytesRead = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + bytesRead);
+    fclose(file);
+
+    constexpr size_t header_size_v1 = 36;
+    constexpr size_t header_size = header_size_v1 + 2 + sha1_size;
+    if (data.size() < header_size_v1 || !std::equal(movie_magic, movie_magic + 4, data.begin()))
+        return false;
+
+    const uint8_t *in = data.data() + 4;
+    const uint8_t *end = data.data() + data.size();
+    const uint64_t version = getLE(in, 2);
+    if ((version != 1 && version != movie_version) || (version == movie_version && data.size() < header_size))
+        return false;
+    const uint64_t mode = getLE(in, 2);
+    if (mode > static_cast<uint8_t>(RngMode::Vip))
+        return false;
+    rng_mode = static_cast<RngMode>(mode);
+    seed = getLE(in, 4);
+    cycles_per_frame = getLE(in, 4);
+    frame_count = getLE(in, 8);
+    framebuffer_hash = getLE(in, 8);
+    const uint64_t count = getLE(in, 4);
+    has_rom_info = version == movie_version;
+    quirks = 0;
+    memset(rom_sha1, 0, sha1_size);
+    if (has_rom_info) {
+        quirks = static_cast<uint8_t>(getLE(in, 2));
+        memcpy(rom_sha1, in, sha1_size);
+        in += sha1_size;
+    }
+
+    events.clear();
+    uint64_t cycle = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t delta;
+        if (!getVarint(in, end, delta) || in == end)
+            return false;
+
+        InputEvent event;
+        cycle += delta;
+        event.cycle = cycle;
+        event.key = *in & 0x0F;
+        event.pressed = (*in & 0x80) != 0;
+        ++in;
+        events.push_back(event);
+    }
+
+    return true;
+}
+
+bool playMovie(Chip8 &chip8, const Movie &movie, const uint8_t *rom_sha1) {
+    if (movie.has_rom_info && rom_sha1 && memcmp(rom_sha1, movie.rom_sha1, sha1_size) != 0) {
+        std::cout << "Movie was recorded with another ROM (SHA-1 " << sha1Hex(movie.rom_sha1) << ")" << std::endl;
+        return false;
+    }
+
+    chip8.setCyclesPerFrame(movie.cycles_per_frame);
+    chip8.setRngMode(movie.rng_mode);
+    if (movie.has_rom_info)
+        chip8.setQuirks(unpackQuirks(movie.quirks));
+
+    size_t next = 0;
+    // Машина с ошибкой стоит и не считает циклы: дальше ролик не сдвинется, ошибку видно по getFault()
+    for (uint64_t frame = 0; frame < movie.frame_count && chip8.getFault() == Fault::None; ++frame) {
+        const uint64_t frame_end = chip8.getCycleCount() + movie.cycles_per_frame;
+
+        while (next < movie.events.size() && movie.events[next].cycle < frame_end
+               && chip8.getFault() == Fault::None) {
+            const InputEvent &event = movie.events[next];
+            if (chip8.queueKeyEvent(event.key, event.pressed, event.cycle)) {
+                ++next;
+                continue;
+            }
+
+            // Очередь забита - доигрываем до этого события, чтобы она разгрузилась
+            const uint64_t now = chip8.getCycleCount();
+            chip8.runCycles(event.cycle > now ? event.cycle - now : 1);
+        }
+
+        if (chip8.getCycleCount() < frame_end)
+            chip8.runCycles(frame_end - chip8.getCycleCount());
+        chip8.tickTimers();
+    }
+
+    return chip8.framebufferHash() == movie.framebuffer_hash;
+}
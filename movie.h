@@ -0,0 +1,35 @@
+#ifndef MOVIE_H
+#define MOVIE_H
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+#include "input_queue.h"
+#include "sha1.h"
+
+// Запись ввода для детерминированного воспроизведения (регрессии, TAS, репро).
+// Вместе с ROM полностью определяет состояние эмулятора после frame_count кадров.
+struct Movie {
+    uint32_t seed = 0; // Сид ГСЧ, с которым вызывался initialize()
+    RngMode rng_mode = RngMode::Xorshift;
+    uint32_t cycles_per_frame = 10;
+    uint64_t frame_count = 0;
+    uint64_t framebuffer_hash = 0; // Chip8::framebufferHash() после последнего кадра
+    uint8_t quirks = 0; // packQuirks() на записи
+    uint8_t rom_sha1[sha1_size] = {}; // SHA-1 ROM, с которым записывали
+    bool has_rom_info = true; // false - ролик версии 1: quirks и ROM в нём нет, их не проверяем
+    std::vector<InputEvent> events; // Отсортированы по cycle
+
+    // Формат: заголовок + события, cycle хранится как varint-дельта от предыдущего
+    bool save(const char *filename) const;
+    bool load(const char *filename);
+};
+
+// Проигрывает запись без окна и без ограничения скорости.
+// chip8 должен быть инициализирован с movie.seed и иметь загруженный ROM; режим ГСЧ и quirks берутся из записи.
+// rom_sha1 - SHA-1 загруженного ROM: ролик с другого ROM не проигрывается (nullptr - не проверять).
+// Возвращает true, если итоговый кадр совпал с записанным побитово. На ошибке машины (getFault())
+// воспроизведение останавливается, сравнивается кадр на момент ошибки.
+bool playMovie(Chip8 &chip8, const Movie &movie, const uint8_t *rom_sha1 = nullptr);
+
+#endif //MOVIE_H
@@ -0,0 +1,11 @@
+#include "output.h"
+
+void framebufferToPixels(const uint8_t *gfx, uint32_t *pixels, const uint32_t on, const uint32_t off) {
+    for (int i = 0; i < 64 * 32; ++i)
+        pixels[i] = gfx[i] ? on : off;
+}
+
+void squareWave(int16_t *buffer, const int count, const uint32_t half_period, uint32_t &phase) {
+    for (int i = 0; i < count; ++i, ++phase)
+        buffer[i] = (phase / half_period) % 2 ? 8000 : -8000;
+}
@@ -0,0 +1,15 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+#include <cstdint>
+
+#include "chip8.h"
+
+// Перевод состояния в то, что уходит в SDL: пиксели и звук. Без SDL, чтобы мерить и встраивать отдельно.
+
+// gfx (0/1 на пиксель) в 64x32 пикселя RGBA8888, как текстура фронтенда
+void framebufferToPixels(const uint8_t* gfx, uint32_t* pixels, uint32_t on = 0xFFFFFFFF, uint32_t off = 0x00000000);
+
+// count сэмплов меандра с полупериодом half_period; phase продолжается между вызовами, чтобы волна не рвалась
+void squareWave(int16_t* buffer, int count, uint32_t half_period, uint32_t& phase);
+
+#endif //OUTPUT_H
@@ -0,0 +1,136 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+unsigned opcodeClass(const uint16_t opcode) {
+    const unsigned family = opcode >> 12;
+    switch (family) {
+        case 0x0:
+            return opcode == 0x00E0 ? 0 : opcode == 0x00EE ? 1 : 2;
+        case 0x8:
+            return 16 + (opcode & 0xF); // 16-31
+        case 0xE:
+            return (opcode & 0xFF) == 0x9E ? 32 : (opcode & 0xFF) == 0xA1 ? 33 : 34;
+        case 0xF:
+            switch (opcode & 0xFF) {
+                case 0x07: return 35;
+                case 0x0A: return 36;
+                case 0x15: return 37;
+                case 0x18: return 38;
+                case 0x1E: return 39;
+                case 0x29: return 40;
+                case 0x33: return 41;
+                case 0x55: return 42;
+                case 0x65: return 43;
+                default: return 44;
+            }
+        default:
+            return 2 + family; // 3-15, 10 не бывает
+    }
+}
+
+const char *opcodeClassName(const unsigned opcode_class) {
+    static const char *const names[opcode_class_count] = {
+        "00E0", "00EE", "0NNN", "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN", "-",
+        "9XY0", "ANNN", "BNNN", "CXNN", "DXYN",
+        "8XY0", "8XY1", "8XY2", "8XY3", "8XY4", "8XY5", "8XY6", "8XY7",
+        "8XY8", "8XY9", "8XYA", "8XYB", "8XYC", "8XYD", "8XYE", "8XYF",
+        "EX9E", "EXA1", "EXNN",
+        "FX07", "FX0A", "FX15", "FX18", "FX1E", "FX29", "FX33", "FX55", "FX65", "FXNN",
+    };
+    return opcode_class < opcode_class_count ? names[opcode_class] : "?";
+}
+
+bool Profiler::writeReport(const char *filename, const unsigned top_addresses) const {
+    FILE *out = fopen(filename, "w");
+    if (!out) {
+        std::cout << "Failed to write profile " << filename << std::endl;
+        return false;
+    }
+
+    const double total = instructions ? static_cast<double>(instructions) : 1;
+    fprintf(out, "instructions %" PRIu64 "\n\n", instructions);
+
+    // Классы по убыванию частоты
+    std::vector<unsigned> classes;
+    for (unsigned c = 0; c < opcode_class_count; ++c)
+        if (class_counts[c])
+            classes.push_back(c);
+    std::sort(classes.begin(), classes.end(), [&](const unsigned a, const unsigned b) {
+        return class_counts[a] > class_counts[b];
+    });
+    fprintf(out, "class      count        share\n");
+    for (const unsigned c : classes)
+        fprintf(out, "%-6s %12" PRIu64 " %11.2f%%\n", opcodeClassName(c), class_counts[c], class_counts[c] * 100 / total);
+
+    uint64_t total_ns = 0;
+    for (const uint64_t ns : group_ns)
+        total_ns += ns;
+    fprintf(out, "\ngroup      host_ms        share\n");
+    for (unsigned g = 0; g < 16; ++g) {
+        if (!group_ns[g])
+            continue;
+        fprintf(out, "%XNNN %12.3f %11.2f%%\n", g, group_ns[g] / 1e6,
+                total_ns ? group_ns[g] * 100.0 / static_cast<double>(total_ns) : 0.0);
+    }
+
+    std::vector<uint16_t> addresses;
+    for (uint16_t a = 0; a < 4096; ++a)
+        if (pc_counts[a])
+            addresses.push_back(a);
+    std::sort(addresses.begin(), addresses.end(), [&](const uint16_t a, const uint16_t b) {
+        return pc_counts[a] > pc_counts[b];
+    });
+    if (addresses.size() > top_addresses)
+        addresses.resize(top_addresses);
+    fprintf(out, "\naddress opcode        count        share\n");
+    for (const uint16_t a : addresses)
+        fprintf(out, "0x%03X   %04X   %12" PRIu64 " %11.2f%%\n", a, pc_opcodes[a], pc_counts[a], pc_counts[a] * 100 / total);
+
+    fclose(out);
+    return true;
+}
+
+bool Profiler::writeHeatmap(const char *filename, unsigned scale) const {
+    FILE *out = fopen(filename, "wb");
+    if (!out) {
+        std::cout << "Failed to write heatmap " << filename << std::endl;
+        return false;
+    }
+    if (!scale)
+        scale = 1;
+
+    uint64_t peak = 0;
+    for (const uint64_t count : pc_counts)
+        peak = std::max(peak, count);
+    // Логарифмическая шкала: горячие петли на порядки горячее остального кода
+    const double log_peak = std::log1p(static_cast<double>(peak));
+
+    const unsigned size = 64 * scale;
+    fprintf(out, "P6\n%u %u\n255\n", size, size);
+    std::vector<uint8_t> row(size * 3);
+    for (unsigned y = 0; y < size; ++y) {
+        for (unsigned x = 0; x < size; ++x) {
+            const uint64_t count = pc_counts[(y / scale) * 64 + x / scale];
+            uint8_t *pixel = &row[x * 3];
+            if (!count) {
+                pixel[0] = pixel[1] = pixel[2] = 0;
+                continue;
+            }
+            // Чёрный - красный - жёлтый - белый
+            const double t = log_peak > 0 ? std::log1p(static_cast<double>(count)) / log_peak : 1;
+            pixel[0] = static_cast<uint8_t>(std::min(1.0, t * 3) * 255);
+            pixel[1] = static_cast<uint8_t>(std::min(1.0, std::max(0.0, t * 3 - 1)) * 255);
+            pixel[2] = static_cast<uint8_t>(std::min(1.0, std::max(0.0, t * 3 - 2)) * 255);
+        }
+        fwrite(row.data(), 1, row.size(), out);
+    }
+
+    fclose(out);
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <chrono>
+#include <cstdint>
+
+#include "chip8.h"
+
+// Класс инструкции по таблице эмулятора: одна ветка switch - один класс
+constexpr unsigned opcode_class_count = 45;
+unsigned opcodeClass(uint16_t opcode);
+const char* opcodeClassName(unsigned opcode_class); // "8XY4", "FX33", "0NNN" и т. п.
+
+// Хуки для Chip8::runCyclesWith: сколько раз выполнялся каждый класс инструкций и каждый адрес гостя,
+// и сколько наносекунд хоста ушло на каждую группу (старший полубайт opcode).
+// Замер времени на каждой инструкции дорогой - профилируемый прогон в разы медленнее обычного.
+class Profiler {
+    uint64_t class_counts[opcode_class_count] = {};
+    uint64_t pc_counts[4096] = {};
+    uint16_t pc_opcodes[4096] = {}; // Последняя инструкция, выполненная по адресу
+    uint64_t group_ns[16] = {};
+    uint64_t instructions = 0;
+
+    uint16_t pc = 0;
+    std::chrono::steady_clock::time_point started;
+
+public:
+    bool beforeInstruction(const Chip8State& state) {
+        pc = state.program_counter & 0xFFF;
+        started = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool afterInstruction(const Chip8State& state) {
+        const auto elapsed = std::chrono::steady_clock::now() - started;
+        group_ns[state.opcode >> 12] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        ++class_counts[opcodeClass(state.opcode)];
+        ++pc_counts[pc];
+        pc_opcodes[pc] = state.opcode;
+        ++instructions;
+        return true;
+    }
+
+    uint64_t getInstructions() const { return instructions; }
+    uint64_t getPcCount(uint16_t address) const { return pc_counts[address & 0xFFF]; }
+
+    // Текстовый отчёт: классы, группы со временем, самые горячие адреса
+    bool writeReport(const char* filename, unsigned top_addresses = 32) const;
+    // Тепловая карта памяти: 64x64 клетки, клетка - адрес (строка - 64 байта), PPM P6; scale - пикселей на клетку
+    bool writeHeatmap(const char* filename, unsigned scale = 8) const;
+};
+
+#endif //PROFILER_H
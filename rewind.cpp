@@ -0,0 +1,194 @@
+#include "rewind.h"
+
+#include <cstring>
+
+namespace {
+    void putVarint(std::vector<uint8_t> &out, size_t value) {
+        while (value >= 0x80) {
+            out.push_back((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(value);
+    }
+
+    bool getVarint(const uint8_t *&in, const uint8_t *end, size_t &value) {
+        value = 0;
+        for (int shift = 0; shift < 35 && in < end; shift += 7) {
+            const uint8_t byte = *in++;
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    // Пары (длина нулей, длина литерала, литерал). XOR-дельта от соседних кадров
+    // сжимается в десятки байт, потому что меняются только регистры и пара строк экрана.
+    void compress(const uint8_t *data, const size_t size, std::vector<uint8_t> &out) {
+        out.clear();
+        size_t i = 0;
+        while (i < size) {
+            const size_t zeros_start = i;
+            while (i < size && data[i] == 0)
+                ++i;
+            const size_t literal_start = i;
+            // Короткие нулевые вставки внутри литерала дешевле, чем новая пара заголовков
+            while (i < size && (data[i] != 0 || (i + 2 < size && (data[i + 1] != 0 || data[i + 2] != 0))))
+                ++i;
+
+            putVarint(out, literal_start - zeros_start);
+            putVarint(out, i - literal_start);
+            out.insert(out.end(), data + literal_start, data + i);
+        }
+    }
+
+    bool decompress(const uint8_t *in, const uint8_t *end, uint8_t *data, const size_t size) {
+        size_t i = 0;
+        while (in < end) {
+            size_t zeros, literal;
+            if (!getVarint(in, end, zeros) || !getVarint(in, end, literal))
+                return false;
+            if (zeros + literal > size - i || literal > static_cast<size_t>(end - in))
+                return false;
+
+            memset(data + i, 0, zeros);
+            i += zeros;
+            memcpy(data + i, in, literal);
+            i += literal;
+            in += literal;
+        }
+        return i == size;
+    }
+}
+
+RewindBuffer::RewindBuffer(const size_t capacity, const uint32_t keyframe_interval)
+    : storage(capacity), keyframe_interval(keyframe_interval ? keyframe_interval : 1) {
+    scratch.reserve(sizeof(Chip8State) * 2);
+}
+
+void RewindBuffer::push(const Chip8State &state, const uint64_t memory_pages, const uint32_t gfx_pages) {
+    const bool keyframe = entries.empty() || since_keyframe + 1 >= keyframe_interval;
+
+    if (!keyframe) {
+        const auto *current = reinterpret_cast<const uint8_t *>(&state);
+        const auto *base = reinterpret_cast<const uint8_t *>(&keyframe_state);
+        const auto xorRange = [&](const size_t offset, const size_t size) {
+            for (size_t i = offset; i < offset + size; ++i)
+                delta[i] = current[i] ^ base[i];
+        };
+
+        // Страницы, которых не касались с ключевого кадра, в delta так и остаются нулями.
+        // Маски только растут до следующего ключевого кадра, поэтому чистить их не нужно.
+        memory_since_keyframe |= memory_pages;
+        gfx_since_keyframe |= gfx_pages;
+        xorRange(0, registers_size);
+        for (int page = 0; page < 32; ++page) {
+            if (gfx_since_keyframe & (1U << page))
+                xorRange(offsetof(Chip8State, gfx) + page * dirty_page_size, dirty_page_size);
+        }
+        for (int page = 0; page < 64; ++page) {
+            if (memory_since_keyframe & (1ULL << page))
+                xorRange(offsetof(Chip8State, memory) + page * dirty_page_size, dirty_page_size);
+        }
+        compress(delta, sizeof(delta), scratch);
+
+        // Группы вытесняются от старых к новым, так что свой ключевой кадр пропадает,
+        // только если вытеснили вообще всё - тогда этот снимок становится ключевым
+        if (store(scratch.data(), scratch.size(), false) && entries.front().keyframe) {
+            ++since_keyframe;
+            return;
+        }
+        clear();
+    }
+
+    keyframe_state = state;
+    resetDelta();
+    compress(reinterpret_cast<const uint8_t *>(&state), sizeof(Chip8State), scratch);
+    store(scratch.data(), scratch.size(), true);
+    since_keyframe = 0;
+}
+
+void RewindBuffer::resetDelta() {
+    memset(delta, 0, sizeof(delta));
+    memory_since_keyframe = 0;
+    gfx_since_keyframe = 0;
+}
+
+void RewindBuffer::evictOldest() {
+    entries.pop_front();
+    // Дельты без своего ключевого кадра бесполезны
+    while (!entries.empty() && !entries.front().keyframe)
+        entries.pop_front();
+}
+
+bool RewindBuffer::store(const uint8_t *data, const size_t size, const bool keyframe) {
+    if (size > storage.size())
+        return false;
+
+    if (head + size > storage.size()) {
+        // За head лежат только снимки с прошлого круга - самые старые
+        while (!entries.empty() && entries.front().offset >= head)
+            evictOldest();
+        head = 0;
+    }
+
+    while (!entries.empty() && entries.front().offset < head + size && head < entries.front().offset + entries.front().size)
+        evictOldest();
+
+    memcpy(storage.data() + head, data, size);
+    entries.push_back({static_cast<uint32_t>(head), static_cast<uint32_t>(size), keyframe});
+    head += size;
+    return true;
+}
+
+bool RewindBuffer::decode(const Entry &entry, Chip8State &state) const {
+    const uint8_t *in = storage.data() + entry.offset;
+    auto *out = reinterpret_cast<uint8_t *>(&state);
+    if (!decompress(in, in + entry.size, out, sizeof(Chip8State)))
+        return false;
+
+    if (!entry.keyframe) {
+        const auto *base = reinterpret_cast<const uint8_t *>(&keyframe_state);
+        for (size_t i = 0; i < sizeof(Chip8State); ++i)
+            out[i] ^= base[i];
+    }
+    return true;
+}
+
+bool RewindBuffer::pop(Chip8State &state) {
+    if (entries.empty())
+        return false;
+
+    const Entry latest = entries.back();
+    entries.pop_back();
+    head = latest.offset;
+    if (!decode(latest, state)) {
+        clear();
+        return false;
+    }
+
+    if (latest.keyframe) {
+        // Дальше назад дельты считаются от предыдущего ключевого кадра
+        since_keyframe = 0;
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if (it->keyframe) {
+                decode(*it, keyframe_state);
+                break;
+            }
+            ++since_keyframe;
+        }
+    } else if (since_keyframe > 0) {
+        --since_keyframe;
+    }
+
+    // Следующий push сравнит всё целиком: после отката маски уже ничего не говорят
+    memory_since_keyframe = ~0ULL;
+    gfx_since_keyframe = ~0U;
+    return true;
+}
+
+void RewindBuffer::clear() {
+    entries.clear();
+    head = 0;
+    since_keyframe = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef REWIND_H
+#define REWIND_H
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "chip8.h"
+
+// Кольцо покадровых снимков для перемотки назад.
+// Каждые keyframe_interval кадров хранится ключевой снимок, остальные - XOR с ним.
+// И то и другое сжато RLE: дельта почти целиком из нулей, ключевой кадр - в основном пустая память.
+// Всё лежит в одном буфере фиксированного размера; старые группы вытесняются целиком.
+class RewindBuffer {
+    struct Entry {
+        uint32_t offset;
+        uint32_t size;
+        bool keyframe;
+    };
+
+    std::vector<uint8_t> storage;
+    std::deque<Entry> entries;
+    size_t head = 0; // Куда писать следующий снимок
+    uint32_t keyframe_interval;
+    uint32_t since_keyframe = 0; // Снимков после последнего ключевого
+    Chip8State keyframe_state; // Распакованный последний ключевой снимок
+    uint64_t memory_since_keyframe = 0; // Грязные страницы, накопленные с ключевого кадра
+    uint32_t gfx_since_keyframe = 0;
+    uint8_t delta[sizeof(Chip8State)] = {};
+    std::vector<uint8_t> scratch;
+
+    bool store(const uint8_t *data, size_t size, bool keyframe);
+    void evictOldest();
+    void resetDelta();
+    bool decode(const Entry &entry, Chip8State &state) const;
+
+public:
+    // 512 Кб - это больше минуты истории для типичной игры при 60 кадрах в секунду
+    explicit RewindBuffer(size_t capacity = 512 * 1024, uint32_t keyframe_interval = 60);
+
+    // Раз в кадр. Маски - страницы, изменённые с прошлого push (Chip8::getDirty*Pages):
+    // сравниваются с ключевым кадром только они и регистры
+    void push(const Chip8State &state, uint64_t memory_pages = ~0ULL, uint32_t gfx_pages = ~0U);
+    bool pop(Chip8State &state); // Самый свежий снимок; false, если история пуста
+    void clear();
+
+    size_t frames() const { return entries.size(); }
+    size_t capacity() const { return storage.size(); }
+};
+
+#endif //REWIND_H
@@ -0,0 +1,134 @@
+#include "romdb.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+    constexpr char romdb_magic[4] = {'C', '8', 'D', 'B'};
+    constexpr uint32_t romdb_version = 1;
+
+    struct RomDbHeader {
+        char magic[4];
+        uint32_t version; // Записан в порядке байт машины: база с чужим порядком не пройдёт проверку
+        uint32_t record_size;
+        uint32_t count;
+    };
+
+    static_assert(sizeof(RomDbHeader) % alignof(RomDbRecord) == 0, "records must stay aligned after the header");
+
+    bool lessSha1(const RomDbRecord &a, const RomDbRecord &b) {
+        return memcmp(a.sha1, b.sha1, sha1_size) < 0;
+    }
+}
+
+const char *platformName(const Platform platform) {
+    switch (platform) {
+        case Platform::Chip8: return "chip8";
+        case Platform::SuperChip: return "schip";
+        case Platform::XoChip: return "xochip";
+    }
+    return "unknown";
+}
+
+bool platformFromName(const char *name, Platform &platform) {
+    for (const Platform candidate : {Platform::Chip8, Platform::SuperChip, Platform::XoChip}) {
+        if (!strcmp(name, platformName(candidate))) {
+            platform = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RomDatabase::open(const char *filename) {
+    records = nullptr;
+    count = 0;
+    if (!file.open(filename)) {
+        std::cout << "Failed to open ROM database " << filename << std::endl;
+        return false;
+    }
+
+    RomDbHeader header{};
+    bool valid = file.size() >= sizeof(header);
+    if (valid) {
+        memcpy(&header, file.data(), sizeof(header));
+        valid = !memcmp(header.magic, romdb_magic, sizeof(romdb_magic)) && header.version == romdb_version
+                && header.record_size == sizeof(RomDbRecord)
+                && (file.size() - sizeof(header)) / sizeof(RomDbRecord) == header.count
+                && (file.size() - sizeof(header)) % sizeof(RomDbRecord) == 0;
+    }
+    if (!valid) {
+        std::cout << filename << " is not a ROM database" << std::endl;
+        file.close();
+        return false;
+    }
+
+    records = reinterpret_cast<const RomDbRecord *>(file.data() + sizeof(header));
+    count = header.count;
+    return true;
+}
+
+const RomDbRecord *RomDatabase::find(const uint8_t sha1[sha1_size]) const {
+    size_t low = 0, high = count;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const int order = memcmp(records[middle].sha1, sha1, sha1_size);
+        if (!order)
+            return &records[middle];
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return nullptr;
+}
+
+const RomDbRecord *RomDatabase::findRom(const uint8_t *data, const size_t size) const {
+    if (!count)
+        return nullptr;
+    uint8_t digest[sha1_size];
+    sha1(data, size, digest);
+    return find(digest);
+}
+
+bool writeRomDatabase(const char *filename, std::vector<RomDbRecord> records) {
+    std::sort(records.begin(), records.end(), lessSha1);
+    for (size_t i = 1; i < records.size(); ++i) {
+        if (!memcmp(records[i - 1].sha1, records[i].sha1, sha1_size)) {
+            std::cout << "Duplicate ROM " << sha1Hex(records[i].sha1) << " in ROM database" << std::endl;
+            return false;
+        }
+    }
+
+    RomDbHeader header{};
+    memcpy(header.magic, romdb_magic, sizeof(romdb_magic));
+    header.version = romdb_version;
+    header.record_size = sizeof(RomDbRecord);
+    header.count = static_cast<uint32_t>(records.size());
+
+    // Через временный файл: оборванная запись не портит прошлую базу
+    const std::string temporary = std::string(filename) + ".tmp";
+    FILE *out = fopen(temporary.c_str(), "wb");
+    if (!out) {
+        std::cout << "Failed to write ROM database " << filename << std::endl;
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1;
+    if (!records.empty())
+        written = written && fwrite(records.data(), sizeof(RomDbRecord), records.size(), out) == records.size();
+    if (fclose(out) != 0 || !written || rename(temporary.c_str(), filename) != 0) {
+        std::cout << "Failed to write ROM database " << filename << std::endl;
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+const char *defaultRomDatabase() {
+    const char *path = getenv("CHIP8_ROMDB");
+    return path && path[0] ? path : nullptr;
+}
@@ -0,0 +1,60 @@
+#ifndef ROMDB_H
+#define ROMDB_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+#include "mapped_file.h"
+#include "sha1.h"
+
+// Под что написан ROM (как platforms в общей базе CHIP-8). Ядро исполняет только набор CHIP-8,
+// платформа задаёт quirks по умолчанию и видна пользователю.
+enum class Platform : uint8_t {
+    Chip8,
+    SuperChip,
+    XoChip,
+};
+
+const char* platformName(Platform platform); // "chip8", "schip", "xochip"
+bool platformFromName(const char* name, Platform& platform);
+
+// Запись базы настроек. Размер фиксированный: файл через mmap - это массив, поиск - двоичный, без разбора.
+// Многобайтные поля - в порядке байт машины, которая собрала базу (его проверяет заголовок).
+struct RomDbRecord {
+    uint8_t sha1[sha1_size]; // Ключ; в файле записи по возрастанию
+    uint8_t platform; // Platform
+    uint8_t quirks; // packQuirks
+    uint16_t cycles_per_frame; // 0 - значение ядра по умолчанию
+    uint32_t palette[2]; // Фон и пиксель, RGBA8888; оба 0 - цвета фронтенда
+    char keys[16]; // Клавиша хоста (символ на клавиатуре) для клавиш CHIP-8 0-F; 0 - клавиша по умолчанию
+    char title[32]; // Название для людей; без нуля, если заняло все 32 байта
+};
+
+static_assert(sizeof(RomDbRecord) == 80, "RomDbRecord is an on-disk format");
+
+// База настроек ROM по SHA-1 содержимого: заголовок и отсортированные записи.
+// Открытие - mmap и проверка заголовка, поиск - двоичный прямо по отображённому файлу.
+// Только чтение, так что одну базу можно делить между потоками.
+class RomDatabase {
+    MappedFile file;
+    const RomDbRecord* records = nullptr;
+    size_t count = 0;
+
+public:
+    bool open(const char* filename);
+
+    size_t size() const { return count; }
+    const RomDbRecord& operator[](size_t i) const { return records[i]; }
+    const RomDbRecord* find(const uint8_t sha1[sha1_size]) const;
+    // Хэширует ROM и ищет его; nullptr - ROM в базе нет
+    const RomDbRecord* findRom(const uint8_t* data, size_t size) const;
+};
+
+// Сортирует записи и пишет базу через временный файл. false - не записалось или есть повтор SHA-1
+bool writeRomDatabase(const char* filename, std::vector<RomDbRecord> records);
+
+// Файл базы по умолчанию: $CHIP8_ROMDB, иначе nullptr
+const char* defaultRomDatabase();
+
+#endif //ROMDB_H
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "romdb.h"
+
+namespace {
+    // Имена битов quirks в исходнике базы, в порядке packQuirks
+    const char *const quirk_names[] = {"shift", "memory", "jump", "logic", "clip"};
+    constexpr unsigned quirk_count = sizeof(quirk_names) / sizeof(quirk_names[0]);
+
+    // Имя набора (Quirks::fromName) или биты через запятую: shift,memory,jump,logic,clip
+    bool parseQuirks(const std::string &text, uint8_t &bits) {
+        Quirks quirks;
+        if (Quirks::fromName(text.c_str(), quirks)) {
+            bits = packQuirks(quirks);
+            return true;
+        }
+        bits = 0;
+        size_t start = 0;
+        while (start <= text.size()) {
+            const size_t comma = std::min(text.find(',', start), text.size());
+            const std::string name = text.substr(start, comma - start);
+            unsigned bit = 0;
+            while (bit < quirk_count && name != quirk_names[bit])
+                ++bit;
+            if (bit == quirk_count)
+                return false;
+            bits |= 1 << bit;
+            start = comma + 1;
+        }
+        return true;
+    }
+
+    // RRGGBB,RRGGBB: фон и пиксель
+    bool parsePalette(const char *text, uint32_t palette[2]) {
+        for (unsigned i = 0; i < 2; ++i) {
+            char *end = nullptr;
+            const unsigned long rgb = strtoul(text, &end, 16);
+            if (end - text != 6 || *end != (i ? '\0' : ','))
+                return false;
+            palette[i] = static_cast<uint32_t>(rgb) << 8 | 0xFF;
+            text = end + 1;
+        }
+        return true;
+    }
+
+    // Строка исходника: <sha1> [platform=NAME] [quirks=NAME|BITS] [speed=N] [palette=RRGGBB,RRGGBB]
+    //                   [keys=16 клавиш для 0-F] [title=всё до конца строки]
+    bool parseRecord(const char *line, RomDbRecord &record, std::string &error) {
+        record = RomDbRecord();
+        if (!parseSha1(line, record.sha1)) {
+            error = "expected a SHA-1";
+            return false;
+        }
+
+        Platform platform = Platform::Chip8;
+        bool quirks_set = false;
+        const char *cursor = line + sha1_size * 2;
+        while (*cursor) {
+            while (*cursor == ' ' || *cursor == '\t')
+                ++cursor;
+            if (!*cursor)
+                break;
+            if (!strncmp(cursor, "title=", 6)) {
+                memcpy(record.title, cursor + 6, strnlen(cursor + 6, sizeof(record.title)));
+                break;
+            }
+
+            const char *end = cursor + strcspn(cursor, " \t");
+            const std::string token(cursor, end);
+            cursor = end;
+            const size_t eq = token.find('=');
+            const std::string name = token.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : token.substr(eq + 1);
+            bool valid = eq != std::string::npos;
+            if (name == "platform")
+                valid = valid && platformFromName(value.c_str(), platform);
+            else if (name == "quirks")
+                valid = valid && (quirks_set = parseQuirks(value, record.quirks));
+            else if (name == "speed") {
+                char *number_end = nullptr;
+                const unsigned long speed = strtoul(value.c_str(), &number_end, 10);
+                valid = valid && !*number_end && speed > 0 && speed <= 0xFFFF;
+                record.cycles_per_frame = static_cast<uint16_t>(speed);
+            } else if (name == "palette")
+                valid = valid && parsePalette(value.c_str(), record.palette);
+            else if (name == "keys") {
+                valid = valid && value.size() == sizeof(record.keys);
+                for (size_t i = 0; valid && i < value.size(); ++i) {
+                    // '.' - клавиша по умолчанию
+                    const char key = static_cast<char>(tolower(static_cast<unsigned char>(value[i])));
+                    record.keys[i] = key == '.' ? '\0' : key;
+                }
+            } else
+                valid = false;
+            if (!valid) {
+                error = "bad " + token;
+                return false;
+            }
+        }
+
+        record.platform = static_cast<uint8_t>(platform);
+        if (!quirks_set) {
+            // Без явных quirks - набор платформы, как в общей базе
+            Quirks quirks;
+            Quirks::fromName(platform == Platform::Chip8 ? "vip" : platformName(platform), quirks);
+            record.quirks = packQuirks(quirks);
+        }
+        return true;
+    }
+
+    void printRecord(const RomDbRecord &record) {
+        printf("%s platform=%s quirks=", sha1Hex(record.sha1).c_str(),
+               platformName(static_cast<Platform>(record.platform)));
+        if (!record.quirks)
+            printf("default");
+        for (unsigned bit = 0, first = 1; bit < quirk_count; ++bit) {
+            if (record.quirks & 1 << bit) {
+                printf("%s%s", first ? "" : ",", quirk_names[bit]);
+                first = 0;
+            }
+        }
+        if (record.cycles_per_frame)
+            printf(" speed=%u", record.cycles_per_frame);
+        if (record.palette[0] || record.palette[1])
+            printf(" palette=%06X,%06X", record.palette[0] >> 8, record.palette[1] >> 8);
+        char keys[sizeof(record.keys) + 1] = {};
+        for (size_t i = 0; i < sizeof(record.keys); ++i)
+            keys[i] = record.keys[i] ? record.keys[i] : '.';
+        if (strspn(keys, ".") != sizeof(record.keys))
+            printf(" keys=%s", keys);
+        if (record.title[0])
+            printf(" title=%.*s", static_cast<int>(sizeof(record.title)), record.title);
+        printf("\n");
+    }
+
+    int compile(const char *source_path, const char *database_path) {
+        FILE *source = fopen(source_path, "r");
+        if (!source) {
+            fprintf(stderr, "Failed to open %s\n", source_path);
+            return 1;
+        }
+
+        std::vector<RomDbRecord> records;
+        char line[512];
+        int number = 0;
+        while (fgets(line, sizeof(line), source)) {
+            ++number;
+            line[strcspn(line, "\r\n")] = '\0';
+            const char *text = line + strspn(line, " \t");
+            if (!*text || *text == '#')
+                continue;
+
+            RomDbRecord record;
+            std::string error;
+            if (!parseRecord(text, record, error)) {
+                fprintf(stderr, "%s:%d: %s\n", source_path, number, error.c_str());
+                fclose(source);
+                return 1;
+            }
+            records.push_back(record);
+        }
+        fclose(source);
+
+        if (!writeRomDatabase(database_path, records))
+            return 1;
+        printf("records=%zu\n", records.size());
+        return 0;
+    }
+}
+
+// База настроек ROM: собирает двоичную базу из текста, печатает её обратно текстом, ищет в ней ROM
+int main(int argc, char *argv[]) {
+    if (argc == 4 && !strcmp(argv[1], "compile"))
+        return compile(argv[2], argv[3]);
+
+    if ((argc == 3 && !strcmp(argv[1], "dump")) || (argc == 4 && !strcmp(argv[1], "lookup"))) {
+        RomDatabase database;
+        if (!database.open(argv[2]))
+            return 1;
+        if (argc == 3) {
+            for (size_t i = 0; i < database.size(); ++i)
+                printRecord(database[i]);
+            return 0;
+        }
+
+        MappedFile rom;
+        if (!rom.open(argv[3])) {
+            fprintf(stderr, "Failed to open %s\n", argv[3]);
+            return 1;
+        }
+        const RomDbRecord *record = database.findRom(rom.data(), rom.size());
+        if (!record)
+            return 2;
+        printRecord(*record);
+        return 0;
+    }
+
+    fprintf(stderr, "Usage: chip8-romdb compile <source> <database>\n"
+            "       chip8-romdb dump <database>\n"
+            "       chip8-romdb lookup <database> <rom>\n"
+            "Source line: <sha1> [platform=chip8|schip|xochip] [quirks=NAME|shift,memory,jump,logic,clip]\n"
+            "             [speed=CYCLES_PER_FRAME] [palette=RRGGBB,RRGGBB] [keys=KEYS] [title=TEXT]\n"
+            "Without quirks= a ROM gets the quirks of its platform. keys= lists the host key for CHIP-8\n"
+            "keys 0-F ('.' keeps the default, default is x123qweasdzc4rfv). title= takes the rest of the line.\n"
+            "chip8 and chip8-headless read the database given by --romdb or $CHIP8_ROMDB, chip8-batch only --romdb.\n");
+    return 1;
+}
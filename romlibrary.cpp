@@ -0,0 +1,250 @@
+#include "romlibrary.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+static const char index_magic[] = "chip8-library 1";
+
+static bool isRomName(const char *name) {
+    const size_t length = strlen(name);
+    if (length < 5 || name[length - 4] != '.')
+        return false;
+    char extension[4];
+    for (unsigned i = 0; i < 3; ++i)
+        extension[i] = static_cast<char>(tolower(static_cast<unsigned char>(name[length - 3 + i])));
+    extension[3] = '\0';
+    return !strcmp(extension, "ch8") || !strcmp(extension, "xo8") || !strcmp(extension, "sc8");
+}
+
+#ifndef _WIN32
+// Один каталог: подкаталоги и ROM с размером и временем. Ссылки на каталоги не идём - петли.
+static void listDirectory(const std::string &root, const std::string &relative, std::vector<std::string> &directories,
+                          std::vector<RomEntry> &files) {
+    const std::string path = relative.empty() ? root : root + "/" + relative;
+    DIR *directory = opendir(path.c_str());
+    if (!directory)
+        return;
+
+    while (const dirent *item = readdir(directory)) {
+        if (!strcmp(item->d_name, ".") || !strcmp(item->d_name, ".."))
+            continue;
+        const std::string name = relative.empty() ? item->d_name : relative + "/" + item->d_name;
+        const std::string full = root + "/" + name;
+        struct stat info{};
+        if (lstat(full.c_str(), &info) != 0)
+            continue;
+        if (S_ISDIR(info.st_mode)) {
+            directories.push_back(name);
+            continue;
+        }
+        if (S_ISLNK(info.st_mode) && (stat(full.c_str(), &info) != 0 || !S_ISREG(info.st_mode)))
+            continue;
+        if (!S_ISREG(info.st_mode) || !isRomName(item->d_name))
+            continue;
+
+        RomEntry entry;
+        entry.path = name;
+        entry.size = static_cast<uint64_t>(info.st_size);
+#if defined(__APPLE__)
+        entry.mtime = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+        entry.mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+        files.push_back(entry);
+    }
+    closedir(directory);
+}
+#endif
+
+void RomLibrary::sortBySha1() {
+    by_sha1.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        by_sha1[i] = i;
+    std::sort(by_sha1.begin(), by_sha1.end(), [this](const size_t a, const size_t b) {
+        return memcmp(entries[a].sha1, entries[b].sha1, sha1_size) < 0;
+    });
+}
+
+bool RomLibrary::scan(const std::string &directory, const unsigned threads, ScanStats *stats) {
+#ifdef _WIN32
+    std::cout << "Scanning ROM libraries is not supported on this platform" << std::endl;
+    return false;
+#else
+    std::string new_root = directory;
+    while (new_root.size() > 1 && new_root.back() == '/')
+        new_root.pop_back();
+    struct stat info{};
+    if (stat(new_root.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        std::cout << "Failed to open ROM directory " << directory << std::endl;
+        return false;
+    }
+
+    // Индекс того же корня - источник готовых хэшей
+    std::vector<RomEntry> previous;
+    if (new_root == root)
+        previous.swap(entries);
+    root = new_root;
+    entries.clear();
+
+    const WorkStealingPool pool(threads);
+    ScanStats local;
+    std::vector<RomEntry> found;
+    std::vector<std::string> level(1); // Корень - пустой относительный путь
+    while (!level.empty()) {
+        local.directories += level.size();
+        std::vector<std::vector<std::string>> directories(level.size());
+        std::vector<std::vector<RomEntry>> files(level.size());
+        pool.run(level.size(), [&](const size_t i) { listDirectory(root, level[i], directories[i], files[i]); });
+
+        level.clear();
+        for (size_t i = 0; i < directories.size(); ++i) {
+            level.insert(level.end(), directories[i].begin(), directories[i].end());
+            found.insert(found.end(), files[i].begin(), files[i].end());
+        }
+    }
+    std::sort(found.begin(), found.end(), [](const RomEntry &a, const RomEntry &b) { return a.path < b.path; });
+    local.files = found.size();
+
+    std::vector<size_t> to_hash;
+    for (size_t i = 0; i < found.size(); ++i) {
+        const auto old = std::lower_bound(previous.begin(), previous.end(), found[i].path,
+                                          [](const RomEntry &entry, const std::string &path) {
+                                              return entry.path < path;
+                                          });
+        if (old != previous.end() && old->path == found[i].path && old->size == found[i].size
+            && old->mtime == found[i].mtime) {
+            memcpy(found[i].sha1, old->sha1, sha1_size);
+            ++local.reused;
+        } else
+            to_hash.push_back(i);
+    }
+
+    std::vector<char> failed(found.size());
+    pool.run(to_hash.size(), [&](const size_t task) {
+        RomEntry &entry = found[to_hash[task]];
+        MappedFile file;
+        if (!file.open(fullPath(entry).c_str())) {
+            failed[to_hash[task]] = 1;
+            return;
+        }
+        sha1(file.data(), file.size(), entry.sha1);
+    });
+
+    for (size_t i = 0; i < found.size(); ++i) {
+        if (failed[i])
+            ++local.failed;
+        else
+            entries.push_back(std::move(found[i]));
+    }
+    local.hashed = to_hash.size() - local.failed;
+    sortBySha1();
+    if (stats)
+        *stats = local;
+    return true;
+#endif
+}
+
+bool RomLibrary::loadIndex(const char *filename) {
+    FILE *in = fopen(filename, "r");
+    if (!in) {
+        std::cout << "Failed to open ROM index " << filename << std::endl;
+        return false;
+    }
+
+    char line[8192];
+    bool valid = fgets(line, sizeof(line), in) && !strncmp(line, index_magic, strlen(index_magic))
+                 && fgets(line, sizeof(line), in) && !strncmp(line, "root ", 5);
+    std::vector<RomEntry> loaded;
+    std::string loaded_root;
+    if (valid) {
+        line[strcspn(line, "\r\n")] = '\0';
+        loaded_root = line + 5;
+    }
+    while (valid && fgets(line, sizeof(line), in)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!line[0])
+            continue;
+
+        RomEntry entry;
+        char *cursor = line + sha1_size * 2;
+        valid = *cursor == ' ' && parseSha1(line, entry.sha1);
+        if (!valid)
+            break;
+        entry.size = strtoull(cursor + 1, &cursor, 10);
+        entry.mtime = strtoll(cursor, &cursor, 10);
+        valid = *cursor == ' ' && cursor[1];
+        if (valid) {
+            entry.path = cursor + 1;
+            loaded.push_back(std::move(entry));
+        }
+    }
+    fclose(in);
+
+    if (!valid) {
+        std::cout << filename << " is not a ROM index" << std::endl;
+        return false;
+    }
+    std::sort(loaded.begin(), loaded.end(), [](const RomEntry &a, const RomEntry &b) { return a.path < b.path; });
+    root = loaded_root;
+    entries.swap(loaded);
+    sortBySha1();
+    return true;
+}
+
+bool RomLibrary::saveIndex(const char *filename) const {
+    // Через временный файл: оборванная запись не портит прошлый индекс
+    const std::string temporary = std::string(filename) + ".tmp";
+    FILE *out = fopen(temporary.c_str(), "w");
+    if (!out) {
+        std::cout << "Failed to write ROM index " << filename << std::endl;
+        return false;
+    }
+
+    fprintf(out, "%s\nroot %s\n", index_magic, root.c_str());
+    for (const RomEntry &entry : entries)
+        fprintf(out, "%s %" PRIu64 " %" PRId64 " %s\n", sha1Hex(entry.sha1).c_str(), entry.size, entry.mtime,
+                entry.path.c_str());
+    const bool written = !ferror(out);
+    if (fclose(out) != 0 || !written || rename(temporary.c_str(), filename) != 0) {
+        std::cout << "Failed to write ROM index " << filename << std::endl;
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+const RomEntry *RomLibrary::findBySha1(const uint8_t sha1[sha1_size]) const {
+    const auto found = std::lower_bound(by_sha1.begin(), by_sha1.end(), sha1, [this](const size_t index, const uint8_t *key) {
+        return memcmp(entries[index].sha1, key, sha1_size) < 0;
+    });
+    return found != by_sha1.end() && !memcmp(entries[*found].sha1, sha1, sha1_size) ? &entries[*found] : nullptr;
+}
+
+std::vector<const RomEntry *> RomLibrary::findByName(const std::string &fragment) const {
+    std::string needle = fragment;
+    for (char &c : needle)
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+
+    std::vector<const RomEntry *> matches;
+    for (const RomEntry &entry : entries) {
+        std::string path = entry.path;
+        for (char &c : path)
+            c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        if (path.find(needle) != std::string::npos)
+            matches.push_back(&entry);
+    }
+    return matches;
+}
@@ -0,0 +1,50 @@
+#ifndef ROMLIBRARY_H
+#define ROMLIBRARY_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sha1.h"
+
+struct RomEntry {
+    std::string path; // Относительно корня библиотеки, через '/'
+    uint64_t size = 0;
+    int64_t mtime = 0; // Наносекунды Unix: правку в ту же секунду тоже видно
+    uint8_t sha1[sha1_size] = {};
+};
+
+struct ScanStats {
+    size_t directories = 0;
+    size_t files = 0; // ROM (.ch8, .xo8, .sc8) в дереве
+    size_t hashed = 0; // Прочитаны и захэшированы заново
+    size_t reused = 0; // Взяты из индекса: размер и время изменения не поменялись
+    size_t failed = 0; // Не открылись
+};
+
+// Библиотека ROM: дерево каталогов с .ch8/.xo8/.sc8 и индекс на диске.
+// Индекс - текст: строка заголовка, строка с корнем, дальше "sha1 size mtime path" по файлу, по возрастанию пути.
+// Следующий scan того же корня перечитывает только новые и изменившиеся файлы.
+class RomLibrary {
+    std::string root;
+    std::vector<RomEntry> entries; // По возрастанию path
+    std::vector<size_t> by_sha1; // Индексы entries по возрастанию sha1
+
+    void sortBySha1();
+
+public:
+    // Обходит root по уровням: каталоги уровня и хэширование файлов идут в threads потоках (0 - по ядрам).
+    // false - root не открылся
+    bool scan(const std::string& directory, unsigned threads = 0, ScanStats* stats = nullptr);
+    bool loadIndex(const char* filename);
+    bool saveIndex(const char* filename) const;
+
+    const std::string& getRoot() const { return root; }
+    const std::vector<RomEntry>& getEntries() const { return entries; }
+    std::string fullPath(const RomEntry& entry) const { return root + "/" + entry.path; }
+    const RomEntry* findBySha1(const uint8_t sha1[sha1_size]) const;
+    // Путь содержит fragment без учёта регистра
+    std::vector<const RomEntry*> findByName(const std::string& fragment) const;
+};
+
+#endif //ROMLIBRARY_H
@@ -0,0 +1,37 @@
+#include "runahead.h"
+
+#include <chrono>
+
+void RunAhead::speculate(Chip8 &chip8) {
+    if (!frames)
+        return;
+
+    saved = chip8.getState();
+    saved_memory_pages = chip8.getDirtyMemoryPages();
+    saved_gfx_pages = chip8.getDirtyGfxPages();
+    saved_input = chip8.getInputPosition();
+    recorder = chip8.getInputRecorder();
+    chip8.setInputRecorder(nullptr);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; ++i)
+        chip8.runFrame();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Скользящее среднее, чтобы одиночный промах планировщика не дёргал флаг.
+    // Оставляем половину кадра на отрисовку и ожидание.
+    const double cost = elapsed.count() / frames;
+    frame_cost_ms = frame_cost_ms > 0 ? frame_cost_ms * 0.9 + cost * 0.1 : cost;
+    keeping_up = frame_cost_ms * (frames + 1) < 1000.0 / 60 / 2;
+}
+
+void RunAhead::restore(Chip8 &chip8) const {
+    if (!frames)
+        return;
+
+    // Состояние ровно то, что было до speculate(), значит и грязные страницы те же
+    chip8.setState(saved);
+    chip8.setDirtyPages(saved_memory_pages, saved_gfx_pages);
+    chip8.rewindInput(saved_input);
+    chip8.setInputRecorder(recorder);
+}
@@ -0,0 +1,37 @@
+#ifndef RUNAHEAD_H
+#define RUNAHEAD_H
+#include <cstdint>
+#include <vector>
+
+#include "chip8.h"
+
+// Run-ahead: после настоящего кадра сохраняем состояние, прогоняем ещё N кадров с тем же вводом,
+// показываем результат и откатываемся. Скрывает задержку в 1-2 кадра, с которой многие ROM
+// читают клавиатуру. Ядро должно успевать минимум (N+1)x реального времени.
+class RunAhead {
+    uint32_t frames;
+    Chip8State saved;
+    uint64_t saved_memory_pages = 0;
+    uint32_t saved_gfx_pages = 0;
+    uint32_t saved_input = 0; // Позиция очереди ввода: события, съеденные упреждающими кадрами, вернутся
+    std::vector<InputEvent>* recorder = nullptr; // Ролик пишет только настоящие кадры
+    double frame_cost_ms = 0; // Сглаженное время одного кадра эмуляции
+    bool keeping_up = true;
+
+public:
+    explicit RunAhead(uint32_t frames = 0) : frames(frames) {}
+
+    uint32_t getFrames() const { return frames; }
+
+    // Вызывать сразу после настоящего runFrame(): уводит chip8 на frames кадров вперёд.
+    // До restore() в очередь ввода chip8 не писать.
+    void speculate(Chip8 &chip8);
+    // После отрисовки: возвращает настоящее состояние
+    void restore(Chip8 &chip8) const;
+
+    // false, если (N+1) кадров эмуляции не помещаются в 1/60 секунды
+    bool keepingUp() const { return keeping_up; }
+    double getFrameCostMs() const { return frame_cost_ms; }
+};
+
+#endif //RUNAHEAD_H
@@ -0,0 +1,113 @@
+#include "runner.h"
+
+#include <chrono>
+#include <memory>
+
+#include "debugger.h"
+#include "gdbstub.h"
+#include "mapped_file.h"
+#include "movie.h"
+#include "profiler.h"
+#include "savestate.h"
+#include "trace.h"
+
+RunResult runHeadless(const RunConfig &config) {
+    RunResult result;
+
+    Movie movie;
+    uint32_t seed = config.seed;
+    uint64_t frames = config.frames;
+    if (!config.movie.empty()) {
+        if (!movie.load(config.movie.c_str()))
+            return result;
+        seed = movie.seed;
+        if (!config.frames_set)
+            frames = movie.frame_count;
+    }
+
+    // Свой экземпляр на прогон и никакого общего состояния - прогоны можно пускать параллельно
+    Chip8 chip8;
+    chip8.initialize(seed);
+    chip8.setRngMode(config.rng_mode);
+    MappedFile rom;
+    if (!rom.open(config.rom.c_str()))
+        return result;
+    Quirks quirks = config.quirks;
+    uint32_t cycles_per_frame = config.cycles_per_frame;
+    // SHA-1 ROM - ключ базы настроек и проверка, что ролик записан с этим же ROM
+    uint8_t rom_sha1[sha1_size] = {};
+    if (config.romdb || !config.movie.empty())
+        sha1(rom.data(), rom.size(), rom_sha1);
+    if (config.romdb && (result.rom_record = config.romdb->find(rom_sha1))) {
+        if (!config.quirks_set)
+            quirks = unpackQuirks(result.rom_record->quirks);
+        if (!cycles_per_frame)
+            cycles_per_frame = result.rom_record->cycles_per_frame;
+    }
+    chip8.setQuirks(quirks);
+    if (cycles_per_frame)
+        chip8.setCyclesPerFrame(cycles_per_frame);
+    if (!chip8.loadROM(rom.data(), rom.size()))
+        return result;
+    result.loaded = true;
+
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t frames_run = 0;
+    if (!config.movie.empty()) {
+        // Ролик сам задаёт скорость, ГСЧ и quirks; после него, если просили, просто идём дальше без ввода
+        result.movie_match = playMovie(chip8, movie, rom_sha1);
+        frames_run = movie.frame_count;
+    }
+    if (!config.breakpoints.empty() || !config.watchpoints.empty()) {
+        Debugger debugger;
+        for (const uint16_t address : config.breakpoints)
+            debugger.setBreakpoint(address);
+        for (const uint16_t address : config.watchpoints)
+            debugger.setWatchpoint(address, 1, true, true);
+        frames_run += debugger.run(chip8, frames > frames_run ? frames - frames_run : 0);
+        if (debugger.getStopReason() != StopReason::Fault && debugger.getStopReason() != StopReason::None) {
+            result.stop = debugger.getStopReason();
+            result.stop_address = debugger.getStopAddress();
+            frames = frames_run; // Дальше не идём, ни профайлером, ни трассой
+        }
+    }
+    if (config.gdb_port) {
+        std::unique_ptr<GdbStub> stub(new GdbStub());
+        if (stub->open(config.gdb_port)) {
+            frames_run += stub->run(chip8, frames > frames_run ? frames - frames_run : 0, !config.frames_set);
+            stub->close();
+        }
+        frames = frames_run; // Не открылся порт или gdb сказал kill - дальше не идём
+    }
+#ifdef CHIP8_PROFILER
+    if (!config.profile.empty()) {
+        std::unique_ptr<Profiler> profiler(new Profiler());
+        for (; frames_run < frames && chip8.getFault() == Fault::None; ++frames_run)
+            chip8.runFrameWith(*profiler);
+        profiler->writeReport((config.profile + ".txt").c_str());
+        profiler->writeHeatmap((config.profile + ".ppm").c_str());
+    }
+#endif
+    if (!config.trace.empty()) {
+        std::unique_ptr<TraceWriter> writer(new TraceWriter());
+        if (writer->open(config.trace.c_str())) {
+            Tracer tracer(*writer);
+            for (; frames_run < frames && chip8.getFault() == Fault::None; ++frames_run)
+                chip8.runFrameWith(tracer);
+            writer->close();
+        }
+    }
+    for (; frames_run < frames && chip8.getFault() == Fault::None; ++frames_run)
+        chip8.runFrame();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const Chip8State &state = chip8.getState();
+    result.frames = frames_run;
+    result.cycles = state.cycle_count;
+    result.framebuffer_hash = chip8.framebufferHash();
+    result.state_hash = stateChecksum(state);
+    result.fault = chip8.getFault();
+    result.pc = state.program_counter;
+    result.seconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,56 @@
+#ifndef RUNNER_H
+#define RUNNER_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "debugger.h"
+#include "romdb.h"
+
+// Один прогон ROM без окна: общий для chip8-headless и chip8-batch
+struct RunConfig {
+    std::string rom;
+    std::string movie; // Пусто - без ролика
+    std::string quirks_name = "default";
+    Quirks quirks;
+    bool quirks_set = false; // Заданы явно: запись базы их не перекрывает
+    uint64_t frames = 600; // С роликом по умолчанию берётся длина ролика
+    bool frames_set = false;
+    uint32_t seed = 0; // С роликом берётся из ролика
+    RngMode rng_mode = RngMode::Xorshift; // Тоже
+    uint32_t cycles_per_frame = 0; // 0 - значение ядра по умолчанию
+    // База настроек (romdb.h): найденный в ней ROM получает свои quirks и скорость, если они не заданы явно.
+    // Только читается, одна на все параллельные прогоны.
+    const RomDatabase* romdb = nullptr;
+    // Только в сборке с CHIP8_PROFILER: отчёт в <profile>.txt и тепловая карта в <profile>.ppm.
+    // Кадры ролика не профилируются, только свободный прогон после него.
+    std::string profile;
+    std::string trace; // Трасса исполнения (trace.h) свободного прогона; разбирается chip8-trace
+    // Отладчик на свободный прогон: прогон останавливается на первом срабатывании, см. RunResult::stop
+    std::vector<uint16_t> breakpoints;
+    std::vector<uint16_t> watchpoints; // Адреса памяти, на чтение и запись
+    // Сервер gdb (gdbstub.h) на 127.0.0.1:gdb_port вместо свободного прогона; 0 - без него.
+    // Цель стоит, пока gdb не подключится и не скажет continue. Без frames_set - живая сессия:
+    // кадры с темпом 60 в секунду без ограничения, пока gdb не скажет kill или detach.
+    uint16_t gdb_port = 0;
+};
+
+struct RunResult {
+    bool loaded = false; // false - не открылся ROM или ролик, остальное не заполнено
+    uint64_t frames = 0;
+    uint64_t cycles = 0;
+    uint64_t framebuffer_hash = 0;
+    uint64_t state_hash = 0; // stateChecksum(): всё состояние без мусора выравнивания, годится в эталон, как framebuffer_hash
+    Fault fault = Fault::None;
+    uint16_t pc = 0;
+    bool movie_match = true;
+    const RomDbRecord* rom_record = nullptr; // Запись config.romdb для этого ROM; nullptr - ROM там нет
+    StopReason stop = StopReason::None; // Breakpoint, ReadWatch или WriteWatch; упавший прогон - в fault
+    uint16_t stop_address = 0; // Debugger::getStopAddress()
+    double seconds = 0; // Только эмуляция, без загрузки
+};
+
+RunResult runHeadless(const RunConfig &config);
+
+#endif //RUNNER_H
@@ -0,0 +1,116 @@
+#include "savestate.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const char savestate_magic[4] = {'C', '8', 'S', 'T'};
+    constexpr uint16_t savestate_version = 3;
+}
+
+uint64_t stateChecksum(const Chip8State &state) {
+    // Флетчер по 64-битным словам в четыре независимые полосы: только сложения без
+    // зависимостей между полосами, 6 Кб считаются за пару сотен наносекунд
+    const auto *bytes = reinterpret_cast<const uint8_t *>(&state);
+    uint64_t sum[4] = {}, sum_of_sums[4] = {};
+
+    size_t offset = 0;
+    for (; offset + 32 <= sizeof(Chip8State); offset += 32) {
+        uint64_t words[4];
+        memcpy(words, bytes + offset, sizeof(words));
+        sum[0] += words[0];
+        sum[1] += words[1];
+        sum[2] += words[2];
+        sum[3] += words[3];
+        sum_of_sums[0] += sum[0];
+        sum_of_sums[1] += sum[1];
+        sum_of_sums[2] += sum[2];
+        sum_of_sums[3] += sum[3];
+    }
+    for (; offset < sizeof(Chip8State); ++offset) {
+        sum[0] += bytes[offset];
+        sum_of_sums[0] += sum[0];
+    }
+
+    uint64_t checksum = 0;
+    for (int lane = 0; lane < 4; ++lane)
+        checksum = (checksum ^ sum[lane] ^ (sum_of_sums[lane] << 32 | sum_of_sums[lane] >> 32)) * 0x100000001B3ULL;
+    return checksum;
+}
+
+void copyDirtyPages(const Chip8State &source, Chip8State &target, uint64_t memory_pages, uint32_t gfx_pages) {
+    memcpy(reinterpret_cast<uint8_t *>(&target), &source, registers_size);
+
+    while (gfx_pages) {
+        const int page = __builtin_ctz(gfx_pages);
+        gfx_pages &= gfx_pages - 1;
+        memcpy(target.gfx + page * dirty_page_size, source.gfx + page * dirty_page_size, dirty_page_size);
+    }
+
+    while (memory_pages) {
+        const int page = __builtin_ctzll(memory_pages);
+        memory_pages &= memory_pages - 1;
+        memcpy(target.memory + page * dirty_page_size, source.memory + page * dirty_page_size, dirty_page_size);
+    }
+}
+
+bool saveState(const Chip8 &chip8, void *buffer, const size_t size) {
+    if (size < savestate_size)
+        return false;
+
+    SavestateHeader header{};
+    memcpy(header.magic, savestate_magic, sizeof(header.magic));
+    header.version = savestate_version;
+    header.byte_order = 0x0102;
+    header.state_size = sizeof(Chip8State);
+    header.checksum = stateChecksum(chip8.getState());
+
+    auto *out = static_cast<uint8_t *>(buffer);
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), &chip8.getState(), sizeof(Chip8State));
+    return true;
+}
+
+bool loadState(Chip8 &chip8, const void *buffer, const size_t size) {
+    if (size < savestate_size)
+        return false;
+
+    const auto *in = static_cast<const uint8_t *>(buffer);
+    SavestateHeader header;
+    memcpy(&header, in, sizeof(header));
+    if (memcmp(header.magic, savestate_magic, sizeof(header.magic)) != 0 || header.version != savestate_version
+        || header.byte_order != 0x0102 || header.state_size != sizeof(Chip8State))
+        return false;
+
+    // Буфер может быть не выровнен, поэтому копируем, а не кастуем
+    Chip8State state;
+    memcpy(&state, in + sizeof(header), sizeof(Chip8State));
+    if (stateChecksum(state) != header.checksum)
+        return false;
+
+    chip8.setState(state);
+    return true;
+}
+
+bool saveStateFile(const Chip8 &chip8, const char *filename) {
+    uint8_t buffer[savestate_size];
+    saveState(chip8, buffer, sizeof(buffer));
+
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+        return false;
+
+    const bool ok = fwrite(buffer, 1, sizeof(buffer), file) == sizeof(buffer);
+    return fclose(file) == 0 && ok;
+}
+
+bool loadStateFile(Chip8 &chip8, const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (!file)
+        return false;
+
+    uint8_t buffer[savestate_size];
+    const size_t bytesRead = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    return loadState(chip8, buffer, bytesRead);
+}
@@ -0,0 +1,35 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+#include <cstddef>
+#include <cstdint>
+
+#include "chip8.h"
+
+// Сериализованный снимок: заголовок + Chip8State как есть.
+// Формат зависит от платформы (порядок байт, выравнивание) - поэтому в заголовке
+// размер состояния и метка порядка байт, чужие снимки просто не загрузятся.
+struct SavestateHeader {
+    char magic[4]; // "C8ST"
+    uint16_t version;
+    uint16_t byte_order; // 0x0102 в порядке байт записавшей машины
+    uint32_t state_size; // sizeof(Chip8State)
+    uint32_t reserved;
+    uint64_t checksum; // stateChecksum() по байтам состояния
+};
+
+constexpr size_t savestate_size = sizeof(SavestateHeader) + sizeof(Chip8State);
+
+uint64_t stateChecksum(const Chip8State &state);
+
+// Копирует в target регистры и только отмеченные страницы памяти и экрана.
+// target должен совпадать с source на момент, с которого копятся маски.
+void copyDirtyPages(const Chip8State &source, Chip8State &target, uint64_t memory_pages, uint32_t gfx_pages);
+
+// Возвращают false, если буфер мал, заголовок не тот или не сошлась контрольная сумма.
+// При ошибке загрузки эмулятор не меняется.
+bool saveState(const Chip8 &chip8, void *buffer, size_t size);
+bool loadState(Chip8 &chip8, const void *buffer, size_t size);
+bool saveStateFile(const Chip8 &chip8, const char *filename);
+bool loadStateFile(Chip8 &chip8, const char *filename);
+
+#endif //SAVESTATE_H
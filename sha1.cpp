@@ -0,0 +1,99 @@
+#include "sha1.h"
+
+#include <cstring>
+
+static uint32_t rotate(const uint32_t value, const unsigned bits) {
+    return value << bits | value >> (32 - bits);
+}
+
+static void processBlock(uint32_t hash[5], const uint8_t *block) {
+    uint32_t w[80];
+    for (unsigned i = 0; i < 16; ++i)
+        w[i] = static_cast<uint32_t>(block[i * 4]) << 24 | block[i * 4 + 1] << 16 | block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    for (unsigned i = 16; i < 80; ++i)
+        w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = hash[0], b = hash[1], c = hash[2], d = hash[3], e = hash[4];
+    for (unsigned i = 0; i < 80; ++i) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        const uint32_t temp = rotate(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotate(b, 30);
+        b = a;
+        a = temp;
+    }
+    hash[0] += a;
+    hash[1] += b;
+    hash[2] += c;
+    hash[3] += d;
+    hash[4] += e;
+}
+
+void sha1(const uint8_t *data, const size_t size, uint8_t digest[sha1_size]) {
+    uint32_t hash[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t offset = 0;
+    for (; offset + 64 <= size; offset += 64)
+        processBlock(hash, data + offset);
+
+    // Хвост, бит 1, нули и длина в битах big-endian - один или два блока
+    uint8_t tail[128] = {};
+    const size_t rest = size - offset;
+    if (rest)
+        memcpy(tail, data + offset, rest);
+    tail[rest] = 0x80;
+    const size_t tail_size = rest < 56 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(size) * 8;
+    for (unsigned i = 0; i < 8; ++i)
+        tail[tail_size - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    for (size_t block = 0; block < tail_size; block += 64)
+        processBlock(hash, tail + block);
+
+    for (unsigned i = 0; i < 5; ++i)
+        for (unsigned j = 0; j < 4; ++j)
+            digest[i * 4 + j] = static_cast<uint8_t>(hash[i] >> (24 - 8 * j));
+}
+
+std::string sha1Hex(const uint8_t digest[sha1_size]) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(sha1_size * 2, '0');
+    for (size_t i = 0; i < sha1_size; ++i) {
+        text[i * 2] = digits[digest[i] >> 4];
+        text[i * 2 + 1] = digits[digest[i] & 0xF];
+    }
+    return text;
+}
+
+static int hexValue(const char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool parseSha1(const char *text, uint8_t digest[sha1_size]) {
+    for (size_t i = 0; i < sha1_size; ++i) {
+        const int high = hexValue(text[i * 2]);
+        const int low = high < 0 ? -1 : hexValue(text[i * 2 + 1]);
+        if (low < 0)
+            return false;
+        digest[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return hexValue(text[sha1_size * 2]) < 0;
+}
@@ -0,0 +1,14 @@
+#ifndef SHA1_H
+#define SHA1_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// SHA-1: ключ ROM в библиотеке и в базе настроек. Для опознания файлов, не для криптографии.
+constexpr size_t sha1_size = 20;
+
+void sha1(const uint8_t* data, size_t size, uint8_t digest[sha1_size]);
+std::string sha1Hex(const uint8_t digest[sha1_size]); // 40 строчных шестнадцатеричных цифр
+bool parseSha1(const char* text, uint8_t digest[sha1_size]); // Ровно 40 цифр, регистр любой
+
+#endif //SHA1_H
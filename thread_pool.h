@@ -0,0 +1,79 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул с кражей работы для пакета заранее известных задач.
+// У каждого потока своя очередь: свою берёт с конца, опустевший поток ворует у соседей с начала.
+// Задачи длинные (прогон ROM), так что мьютекс на очередь ничего не стоит.
+class WorkStealingPool {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    unsigned thread_count;
+
+public:
+    explicit WorkStealingPool(unsigned threads = 0)
+        : thread_count(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+    unsigned threads() const { return thread_count; }
+
+    // Вызывает task(i) для i из [0, count) и ждёт, пока всё закончится
+    void run(const size_t count, const std::function<void(size_t)> &task) const {
+        const unsigned workers = static_cast<unsigned>(std::min<size_t>(thread_count, count));
+        if (!workers)
+            return;
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        for (unsigned i = 0; i < workers; ++i)
+            queues.emplace_back(new Queue);
+        // Раздаём подряд идущими кусками: соседние задачи часто про один ROM
+        for (size_t i = 0; i < count; ++i)
+            queues[i * workers / count]->tasks.push_back(i);
+
+        const auto worker = [&](const unsigned self) {
+            while (true) {
+                size_t index;
+                bool found = false;
+                for (unsigned attempt = 0; attempt < workers && !found; ++attempt) {
+                    Queue &queue = *queues[(self + attempt) % workers];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    if (queue.tasks.empty())
+                        continue;
+
+                    if (attempt == 0) {
+                        index = queue.tasks.back();
+                        queue.tasks.pop_back();
+                    } else {
+                        index = queue.tasks.front();
+                        queue.tasks.pop_front();
+                    }
+                    found = true;
+                }
+
+                // Новых задач не появляется, так что пустые очереди у всех - это конец
+                if (!found)
+                    return;
+                task(index);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < workers; ++i)
+            threads.emplace_back(worker, i);
+        worker(0);
+        for (std::thread &thread: threads)
+            thread.join();
+    }
+};
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,83 @@
+#include "trace.h"
+
+#include <cstring>
+#include <iostream>
+
+static const char trace_magic[4] = {'C', '8', 'T', 'R'};
+static constexpr uint16_t trace_version = 1;
+
+bool TraceWriter::open(const char *filename) {
+    close();
+    file = fopen(filename, "wb");
+    if (!file) {
+        std::cout << "Failed to open trace " << filename << std::endl;
+        return false;
+    }
+
+    TraceHeader header{};
+    memcpy(header.magic, trace_magic, sizeof(header.magic));
+    header.version = trace_version;
+    header.byte_order = 0x0102;
+    header.record_size = sizeof(TraceRecord);
+    fwrite(&header, sizeof(header), 1, file);
+
+    if (!ring)
+        ring.reset(new TraceRecord[chunk_records * chunk_count]);
+    current = ring.get();
+    position = 0;
+    produced = 0;
+    consumed = 0;
+    stopping = false;
+    failed = false;
+    flusher = std::thread(&TraceWriter::flushLoop, this);
+    return true;
+}
+
+bool TraceWriter::close() {
+    if (!file)
+        return true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    flusher.join();
+
+    // Неполный кусок дописываем сами: фоновый поток уже стоит
+    if (position && fwrite(current, sizeof(TraceRecord), position, file) != position)
+        failed = true;
+    if (fclose(file) != 0)
+        failed = true;
+    file = nullptr;
+    position = 0;
+    return !failed;
+}
+
+void TraceWriter::submit() {
+    std::unique_lock<std::mutex> lock(mutex);
+    ++produced;
+    changed.notify_all();
+    // Кольцо полное - ждём, пока фоновый поток освободит кусок
+    changed.wait(lock, [this] { return produced - consumed < chunk_count; });
+    current = ring.get() + (produced % chunk_count) * chunk_records;
+    position = 0;
+}
+
+void TraceWriter::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        changed.wait(lock, [this] { return consumed < produced || stopping; });
+        if (consumed == produced)
+            return; // stopping и всё записано
+
+        const TraceRecord *chunk = ring.get() + (consumed % chunk_count) * chunk_records;
+        lock.unlock();
+        const bool written = fwrite(chunk, sizeof(TraceRecord), chunk_records, file) == chunk_records;
+        lock.lock();
+        if (!written)
+            failed = true;
+        ++consumed;
+        changed.notify_all();
+    }
+}
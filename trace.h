@@ -0,0 +1,109 @@
+#ifndef TRACE_H
+#define TRACE_H
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "chip8.h"
+
+// Трасса исполнения: запись фиксированного размера на каждую инструкцию.
+// Файл: TraceHeader, потом записи подряд; порядок байт - записавшей машины.
+struct TraceHeader {
+    char magic[4]; // "C8TR"
+    uint16_t version;
+    uint16_t byte_order; // 0x0102
+    uint16_t record_size; // sizeof(TraceRecord)
+    uint16_t reserved;
+};
+
+constexpr uint8_t trace_no_register = 0x80; // VX инструкции не изменился
+constexpr uint8_t trace_more_registers = 0x40; // Изменился и VF (8XYN, DXYN); V0-VX у FX65 - по opcode
+
+struct TraceRecord {
+    uint16_t pc; // Адрес инструкции
+    uint16_t opcode;
+    uint16_t index; // I после инструкции
+    uint8_t reg; // X инструкции (младшие 4 бита) и флаги trace_*
+    uint8_t value; // VX после инструкции
+};
+
+static_assert(sizeof(TraceRecord) == 8, "trace records must stay 8 bytes");
+
+// Кольцо из больших кусков: эмулятор пишет в текущий кусок, полные куски сбрасывает на диск
+// фоновый поток одним fwrite. Если диск не успевает и кольцо заполнилось, эмулятор ждёт - записи не теряются.
+// Писатель один на поток эмуляции: push не потокобезопасен.
+class TraceWriter {
+    static constexpr size_t chunk_records = 1 << 16; // 512 Кб
+    static constexpr size_t chunk_count = 8;
+
+    std::unique_ptr<TraceRecord[]> ring;
+    TraceRecord* current = nullptr;
+    size_t position = 0; // Записей в текущем куске
+    uint64_t produced = 0; // Полных кусков отдано фоновому потоку
+    uint64_t consumed = 0; // Из них уже записано
+    bool stopping = false;
+    bool failed = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread flusher;
+    FILE* file = nullptr;
+
+    void submit();
+    void flushLoop();
+
+public:
+    TraceWriter() = default;
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+    ~TraceWriter() { close(); }
+
+    bool open(const char* filename);
+    // Дописывает остаток и закрывает файл; false - была ошибка записи
+    bool close();
+
+    void push(const TraceRecord& record) {
+        current[position] = record;
+        if (++position == chunk_records)
+            submit();
+    }
+};
+
+// Хуки для Chip8::runCyclesWith: по записи TraceRecord на инструкцию.
+// Регистры сравниваем только побайтно: чтение V словами сразу после побайтовой записи
+// упирается в store forwarding и стоит дороже всей остальной трассировки.
+class Tracer {
+    TraceWriter& writer;
+    uint16_t pc = 0;
+    uint8_t x = 0;
+    uint8_t vx = 0; // VX и VF до инструкции
+    uint8_t vf = 0;
+
+public:
+    explicit Tracer(TraceWriter& target) : writer(target) {}
+
+    bool beforeInstruction(const Chip8State& state) {
+        pc = state.program_counter & 0xFFF;
+        x = state.memory[pc] & 0x0F;
+        vx = state.V[x];
+        vf = state.V[0xF];
+        return true;
+    }
+
+    bool afterInstruction(const Chip8State& state) {
+        const uint8_t value = state.V[x];
+        TraceRecord record;
+        record.pc = pc;
+        record.opcode = state.opcode;
+        record.index = state.index;
+        record.reg = static_cast<uint8_t>(x | (value == vx ? trace_no_register : 0)
+                                          | (x != 0xF && state.V[0xF] != vf ? trace_more_registers : 0));
+        record.value = value;
+        writer.push(record);
+        return true;
+    }
+};
+
+#endif //TRACE_H
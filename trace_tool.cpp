@@ -0,0 +1,121 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "trace.h"
+
+namespace {
+    struct Filter {
+        uint16_t pc_low = 0;
+        uint16_t pc_high = 0xFFF;
+        uint16_t opcode_mask = 0;
+        uint16_t opcode_value = 0;
+        int reg = -1; // Только записи, где изменился этот V (VF - и как флаг)
+        uint64_t from = 0;
+        uint64_t limit = UINT64_MAX;
+
+        bool matches(const TraceRecord &record) const {
+            if (record.pc < pc_low || record.pc > pc_high)
+                return false;
+            if ((record.opcode & opcode_mask) != opcode_value)
+                return false;
+            if (reg >= 0) {
+                const bool vx = !(record.reg & trace_no_register) && (record.reg & 0x0F) == reg;
+                const bool vf = reg == 0xF && (record.reg & trace_more_registers);
+                if (!vx && !vf)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    // "200" или "200-2FF", шестнадцатеричные
+    bool parseRange(const char *text, uint16_t &low, uint16_t &high) {
+        char *end = nullptr;
+        low = static_cast<uint16_t>(strtoul(text, &end, 16));
+        high = low;
+        if (*end == '-')
+            high = static_cast<uint16_t>(strtoul(end + 1, &end, 16));
+        return *end == '\0' && low <= high;
+    }
+
+    // "F0FF=F033": opcode & F0FF == F033
+    bool parseOpcode(const char *text, uint16_t &mask, uint16_t &value) {
+        char *end = nullptr;
+        mask = static_cast<uint16_t>(strtoul(text, &end, 16));
+        if (*end != '=')
+            return false;
+        value = static_cast<uint16_t>(strtoul(end + 1, &end, 16));
+        return *end == '\0' && (value & ~mask) == 0;
+    }
+}
+
+// Разбор трассы chip8-headless --trace: печать с фильтрами по адресу, инструкции и регистру
+int main(int argc, char *argv[]) {
+    const char *path = nullptr;
+    Filter filter;
+    bool usage = false;
+    for (int i = 1; i < argc && !usage; ++i) {
+        if (!strcmp(argv[i], "--pc") && i + 1 < argc)
+            usage = !parseRange(argv[++i], filter.pc_low, filter.pc_high);
+        else if (!strcmp(argv[i], "--opcode") && i + 1 < argc)
+            usage = !parseOpcode(argv[++i], filter.opcode_mask, filter.opcode_value);
+        else if (!strcmp(argv[i], "--reg") && i + 1 < argc)
+            filter.reg = static_cast<int>(strtol(argv[++i], nullptr, 16)) & 0xF;
+        else if (!strcmp(argv[i], "--from") && i + 1 < argc)
+            filter.from = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--limit") && i + 1 < argc)
+            filter.limit = strtoull(argv[++i], nullptr, 10);
+        else if (argv[i][0] != '-' && !path)
+            path = argv[i];
+        else
+            usage = true;
+    }
+
+    if (usage || !path) {
+        fprintf(stderr, "Usage: chip8-trace <trace> [--pc LO[-HI]] [--opcode MASK=VALUE] [--reg X] "
+                "[--from N] [--limit N]\n"
+                "Addresses, opcodes and registers are hexadecimal; --from skips N instructions.\n"
+                "VX=NN is the instruction's X register when it changed, VF* marks a changed VF.\n");
+        return 1;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return 1;
+    }
+
+    TraceHeader header{};
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "C8TR", 4) != 0
+        || header.version != 1 || header.byte_order != 0x0102 || header.record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s is not a trace from this build\n", path);
+        fclose(file);
+        return 1;
+    }
+
+    std::vector<TraceRecord> records(1 << 16);
+    uint64_t number = 0;
+    uint64_t printed = 0;
+    size_t count;
+    while (printed < filter.limit && (count = fread(records.data(), sizeof(TraceRecord), records.size(), file)) > 0) {
+        for (size_t i = 0; i < count && printed < filter.limit; ++i, ++number) {
+            const TraceRecord &record = records[i];
+            if (number < filter.from || !filter.matches(record))
+                continue;
+
+            printf("%" PRIu64 " pc=%03X op=%04X I=%03X", number, record.pc, record.opcode, record.index);
+            if (!(record.reg & trace_no_register))
+                printf(" V%X=%02X", record.reg & 0x0F, record.value);
+            if (record.reg & trace_more_registers)
+                printf(" VF*");
+            printf("\n");
+            ++printed;
+        }
+    }
+
+    fclose(file);
+    return 0;
+}